@@ -0,0 +1,243 @@
+#include "bitboard.h"
+
+static const uint64_t NOT_A_FILE = 0xfefefefefefefefeULL;
+static const uint64_t NOT_H_FILE = 0x7f7f7f7f7f7f7f7fULL;
+
+/*
+ * Shifts every disc one square in direction dir (0-7), dropping discs
+ * that would wrap around the edge of the board.
+ */
+static inline uint64_t shift(uint64_t b, int dir) {
+    switch (dir) {
+        case 0: return (b << 1) & NOT_A_FILE;   // x + 1
+        case 1: return (b >> 1) & NOT_H_FILE;   // x - 1
+        case 2: return b << 8;                  // y + 1
+        case 3: return b >> 8;                  // y - 1
+        case 4: return (b << 9) & NOT_A_FILE;   // x + 1, y + 1
+        case 5: return (b << 7) & NOT_H_FILE;   // x - 1, y + 1
+        case 6: return (b >> 7) & NOT_A_FILE;   // x + 1, y - 1
+        default: return (b >> 9) & NOT_H_FILE;  // x - 1, y - 1
+    }
+}
+
+/*
+ * Returns the set of squares where the side owning "mine" may legally play.
+ */
+uint64_t bbMoves(uint64_t mine, uint64_t theirs) {
+    uint64_t empty = ~(mine | theirs);
+    uint64_t moves = 0;
+
+    for (int dir = 0; dir < 8; dir++) {
+        // Runs of opponent discs adjacent to one of ours, up to 6 long.
+        uint64_t run = shift(mine, dir) & theirs;
+        run |= shift(run, dir) & theirs;
+        run |= shift(run, dir) & theirs;
+        run |= shift(run, dir) & theirs;
+        run |= shift(run, dir) & theirs;
+        run |= shift(run, dir) & theirs;
+        moves |= shift(run, dir) & empty;
+    }
+    return moves;
+}
+
+/*
+ * Returns the opponent discs flipped by playing on square sq.
+ */
+uint64_t bbFlips(uint64_t mine, uint64_t theirs, int sq) {
+    uint64_t flips = 0;
+
+    for (int dir = 0; dir < 8; dir++) {
+        uint64_t line = 0;
+        uint64_t b = shift(1ULL << sq, dir);
+        while (b & theirs) {
+            line |= b;
+            b = shift(b, dir);
+        }
+        if (b & mine) flips |= line;
+    }
+    return flips;
+}
+
+/*
+ * Plays sq (or PASS_MOVE) for the side owning "mine" and swaps the two
+ * boards, so that on return "mine" again belongs to the side to move.
+ */
+void bbDoMove(uint64_t *mine, uint64_t *theirs, int sq) {
+    uint64_t m = *mine;
+    uint64_t t = *theirs;
+
+    if (sq != PASS_MOVE) {
+        uint64_t flips = bbFlips(m, t, sq);
+        m |= flips | (1ULL << sq);
+        t &= ~flips;
+    }
+    *mine = t;
+    *theirs = m;
+}
+
+/*
+ * Bitboard version of Board::dynamic_heuristic_evaluation_function, scoring
+ * the position for the side owning "mine". Gives exactly the same values.
+ */
+double bbEvaluate(uint64_t mine, uint64_t theirs) {
+    static const int V[64] = {
+        20, -3, 11, 8, 8, 11, -3, 20,
+        -3, -7, -4, 1, 1, -4, -7, -3,
+        11, -4, 2, 2, 2, 2, -4, 11,
+        8, 1, 2, -3, -3, 2, 1, 8,
+        8, 1, 2, -3, -3, 2, 1, 8,
+        11, -4, 2, 2, 2, 2, -4, 11,
+        -3, -7, -4, 1, 1, -4, -7, -3,
+        20, -3, 11, 8, 8, 11, -3, 20
+    };
+    static const uint64_t CORNERS = 0x8100000000000081ULL;
+    static const uint64_t CORNER[4] = { 1ULL, 1ULL << 7, 1ULL << 56, 1ULL << 63 };
+    // Squares next to each corner, in the same order as CORNER.
+    static const uint64_t CORNER_ZONE[4] = {
+        0x0000000000000302ULL, 0x000000000000c040ULL,
+        0x0203000000000000ULL, 0x40c0000000000000ULL
+    };
+    double p = 0, c = 0, l = 0, m = 0, f = 0, d = 0;
+    uint64_t taken = mine | theirs;
+
+    // Piece difference, frontier disks and disk squares. As in Board, a
+    // "frontier" disc is one with at least one occupied neighbour.
+    for (uint64_t b = mine; b; b &= b - 1) d += V[bbFirst(b)];
+    for (uint64_t b = theirs; b; b &= b - 1) d -= V[bbFirst(b)];
+
+    uint64_t nextToDisc = 0;
+    for (int dir = 0; dir < 8; dir++) nextToDisc |= shift(taken, dir);
+
+    int my_tiles = bbCount(mine);
+    int opp_tiles = bbCount(theirs);
+    int my_front_tiles = bbCount(mine & nextToDisc);
+    int opp_front_tiles = bbCount(theirs & nextToDisc);
+
+    if (my_tiles > opp_tiles)
+        p = (100.0 * my_tiles) / (my_tiles + opp_tiles);
+    else if (my_tiles < opp_tiles)
+        p = -(100.0 * opp_tiles) / (my_tiles + opp_tiles);
+
+    if (my_front_tiles > opp_front_tiles)
+        f = -(100.0 * my_front_tiles) / (my_front_tiles + opp_front_tiles);
+    else if (my_front_tiles < opp_front_tiles)
+        f = (100.0 * opp_front_tiles) / (my_front_tiles + opp_front_tiles);
+
+    // Corner occupancy
+    c = 25 * (bbCount(mine & CORNERS) - bbCount(theirs & CORNERS));
+
+    // Corner closeness
+    my_tiles = opp_tiles = 0;
+    for (int i = 0; i < 4; i++) {
+        if (taken & CORNER[i]) continue;
+        my_tiles += bbCount(mine & CORNER_ZONE[i]);
+        opp_tiles += bbCount(theirs & CORNER_ZONE[i]);
+    }
+    l = -12.5 * (my_tiles - opp_tiles);
+
+    // Mobility
+    my_tiles = bbCount(bbMoves(mine, theirs));
+    opp_tiles = bbCount(bbMoves(theirs, mine));
+    if (my_tiles > opp_tiles)
+        m = (100.0 * my_tiles) / (my_tiles + opp_tiles);
+    else if (my_tiles < opp_tiles)
+        m = -(100.0 * opp_tiles) / (my_tiles + opp_tiles);
+
+    // final weighted score
+    return (10 * p) + (801.724 * c) + (382.026 * l) + (78.922 * m) + (74.396 * f) + (10 * d);
+}
+
+static uint64_t mirrorX(uint64_t b) {
+    b = ((b >> 1) & 0x5555555555555555ULL) | ((b & 0x5555555555555555ULL) << 1);
+    b = ((b >> 2) & 0x3333333333333333ULL) | ((b & 0x3333333333333333ULL) << 2);
+    b = ((b >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((b & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    return b;
+}
+
+static uint64_t mirrorY(uint64_t b) {
+    return __builtin_bswap64(b);
+}
+
+static uint64_t transpose(uint64_t b) {
+    uint64_t t;
+    t = (b ^ (b >> 7)) & 0x00aa00aa00aa00aaULL;
+    b ^= t ^ (t << 7);
+    t = (b ^ (b >> 14)) & 0x0000cccc0000ccccULL;
+    b ^= t ^ (t << 14);
+    t = (b ^ (b >> 28)) & 0x00000000f0f0f0f0ULL;
+    b ^= t ^ (t << 28);
+    return b;
+}
+
+/*
+ * Applies symmetry sym (0-7) to a bitboard.
+ */
+uint64_t bbTransform(uint64_t b, int sym) {
+    if (sym & 4) b = transpose(b);
+    if (sym & 1) b = mirrorX(b);
+    if (sym & 2) b = mirrorY(b);
+    return b;
+}
+
+/*
+ * Applies symmetry sym to a square index; PASS_MOVE is left alone.
+ */
+int bbTransformSquare(int sq, int sym) {
+    if (sq == PASS_MOVE) return sq;
+    int x = sq % 8;
+    int y = sq / 8;
+    if (sym & 4) {
+        int tmp = x;
+        x = y;
+        y = tmp;
+    }
+    if (sym & 1) x = 7 - x;
+    if (sym & 2) y = 7 - y;
+    return x + 8 * y;
+}
+
+/*
+ * Returns the symmetry that undoes sym.
+ */
+int bbInverse(int sym) {
+    // Mirrors commute with each other, but swap roles under a transpose.
+    if ((sym & 4) && (sym & 3) != 0 && (sym & 3) != 3) return sym ^ 3;
+    return sym;
+}
+
+/*
+ * Replaces the position by its canonical form, the smallest of its eight
+ * symmetric images, and returns the symmetry that produced it.
+ */
+int bbCanonical(uint64_t *mine, uint64_t *theirs) {
+    uint64_t bestMine = *mine;
+    uint64_t bestTheirs = *theirs;
+    int best = 0;
+
+    for (int sym = 1; sym < 8; sym++) {
+        uint64_t m = bbTransform(*mine, sym);
+        uint64_t t = bbTransform(*theirs, sym);
+        if (m < bestMine || (m == bestMine && t < bestTheirs)) {
+            bestMine = m;
+            bestTheirs = t;
+            best = sym;
+        }
+    }
+    *mine = bestMine;
+    *theirs = bestTheirs;
+    return best;
+}
+
+/*
+ * 64-bit hash of a position. Hash the canonical form to make it the same
+ * for all symmetric positions.
+ */
+uint64_t bbHash(uint64_t mine, uint64_t theirs) {
+    uint64_t h = mine * 0x9e3779b97f4a7c15ULL ^ (theirs + 0x632be59bd9b4e019ULL);
+    h ^= h >> 31;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 29;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,36 @@
+#ifndef __BITBOARD_H__
+#define __BITBOARD_H__
+
+#include <stdint.h>
+
+/*
+ * Fast 64-bit bitboard helpers. Square (x, y) is bit x + 8*y, the same
+ * layout Board uses. Every function takes the discs of the side to move
+ * first ("mine") and the opponent's discs second ("theirs").
+ */
+
+// Square index used to represent a pass.
+#define PASS_MOVE 64
+
+uint64_t bbMoves(uint64_t mine, uint64_t theirs);
+uint64_t bbFlips(uint64_t mine, uint64_t theirs, int sq);
+void bbDoMove(uint64_t *mine, uint64_t *theirs, int sq);
+double bbEvaluate(uint64_t mine, uint64_t theirs);
+
+// The eight symmetries of the board: bit 2 transposes, then bit 0 mirrors
+// x and bit 1 mirrors y.
+uint64_t bbTransform(uint64_t b, int sym);
+int bbTransformSquare(int sq, int sym);
+int bbInverse(int sym);
+int bbCanonical(uint64_t *mine, uint64_t *theirs);
+uint64_t bbHash(uint64_t mine, uint64_t theirs);
+
+inline int bbCount(uint64_t b) {
+    return __builtin_popcountll(b);
+}
+
+inline int bbFirst(uint64_t b) {
+    return __builtin_ctzll(b);
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "board.h"
+#include "bitboard.h"
 
 /*
  * Make a standard 8x8 othello board and initialize it to the standard setup.
@@ -10,12 +11,15 @@ Board::Board() {
     taken.set(4 + 8 * 4);
     black.set(4 + 8 * 3);
     black.set(3 + 8 * 4);
+    net = NULL;
+    acc = NULL;
 }
 
 /*
  * Destructor for the board.
  */
 Board::~Board() {
+    delete acc;
 }
 
 /*
@@ -25,6 +29,8 @@ Board *Board::copy() {
     Board *newBoard = new Board();
     newBoard->black = black;
     newBoard->taken = taken;
+    newBoard->net = net;
+    if (acc != NULL) newBoard->acc = new Accumulator(*acc);
     return newBoard;
 }
 
@@ -114,6 +120,9 @@ void Board::doMove(Move *m, Side side) {
 
     int X = m->getX();
     int Y = m->getY();
+    uint64_t before, theirs = 0;
+    if (net != NULL) getBits(side, &before, &theirs);
+
     Side other = (side == BLACK) ? WHITE : BLACK;
     for (int dx = -1; dx <= 1; dx++) {
         for (int dy = -1; dy <= 1; dy++) {
@@ -140,6 +149,13 @@ void Board::doMove(Move *m, Side side) {
         }
     }
     set(side, X, Y);
+
+    // Keep the network accumulator in step using the discs that flipped.
+    if (net != NULL) {
+        uint64_t after, unused;
+        getBits(side, &after, &unused);
+        net->make(acc, side, X + 8 * Y, after & theirs);
+    }
 }
 
 /*
@@ -178,6 +194,26 @@ void Board::setBoard(char data[]) {
             taken.set(i);
         }
     }
+    if (net != NULL) setNetwork(net);
+}
+
+/*
+ * Exports the board as two 64-bit bitboards, seen from the given side.
+ */
+void Board::getBits(Side side, uint64_t *mine, uint64_t *theirs) {
+    uint64_t b = black.to_ullong();
+    uint64_t w = taken.to_ullong() & ~b;
+    *mine = (side == BLACK) ? b : w;
+    *theirs = (side == BLACK) ? w : b;
+}
+
+/*
+ * Sets the board state from two 64-bit bitboards, seen from the given side.
+ */
+void Board::setBits(Side side, uint64_t mine, uint64_t theirs) {
+    taken = bitset<64>(mine | theirs);
+    black = bitset<64>((side == BLACK) ? mine : theirs);
+    if (net != NULL) setNetwork(net);
 }
 
 std::vector<Move> Board::getAllMoves(Side side){
@@ -205,124 +241,40 @@ int Board::numValidMoves(Side side){
     return count;
 }
 
+/*
+ * Weighted mix of disc difference, disc squares, frontier discs, corner
+ * occupancy, corner closeness and mobility, scored for the given side.
+ * The computation itself lives in bbEvaluate().
+ */
 double Board::dynamic_heuristic_evaluation_function(Side side)  {
+    uint64_t mine, theirs;
+    getBits(side, &mine, &theirs);
+    return bbEvaluate(mine, theirs);
+}
 
-    int my_tiles = 0, opp_tiles = 0, i, j, k, my_front_tiles = 0, opp_front_tiles = 0, x, y;
-    double p = 0, c = 0, l = 0, m = 0, f = 0, d = 0;
-
-    int X1[] = {-1, -1, 0, 1, 1, 1, 0, -1};
-    int Y1[] = {0, 1, 1, 1, 0, -1, -1, -1};
-    int V[8][8] = {
-        {20, -3, 11, 8, 8, 11, -3, 20},
-        {-3, -7, -4, 1, 1, -4, -7, -3},
-        {11, -4, 2, 2, 2, 2, -4, 11},
-        {8, 1, 2, -3, -3, 2, 1, 8},
-        {8, 1, 2, -3, -3, 2, 1, 8},
-        {11, -4, 2, 2, 2, 2, -4, 11},
-        {-3, -7, -4, 1, 1, -4, -7, -3},
-        {20, -3, 11, 8, 8, 11, -3, 20}
-    };
-    // Piece difference, frontier disks and disk squares
-    for(i=0; i<8; i++){
-        for(j=0; j<8; j++)  {
-            if(get(side, i, j))  {
-                d += V[i][j];
-                my_tiles++;
-            } else if(occupied(i, j))  {
-                d -= V[i][j];
-                opp_tiles++;
-            }
-            if(occupied(i, j))   {
-                for(k=0; k<8; k++)  {
-                    x = i + X1[k]; 
-                    y = j + Y1[k];
-                    if(x >= 0 && x < 8 && y >= 0 && y < 8 && occupied(x, y)) {
-                        if(get(side, i, j))  my_front_tiles++;
-                        else opp_front_tiles++;
-                        break;
-                    }
-                }
-            }
-        }
+/*
+ * Attaches a network to the board (NULL detaches it). While one is
+ * attached, doMove() keeps its accumulator up to date, and copies of the
+ * board share the network. The accumulator only exists while a network is
+ * attached, so plain boards stay small.
+ */
+void Board::setNetwork(const Network *network) {
+    net = network;
+    if (net == NULL) {
+        delete acc;
+        acc = NULL;
+        return;
     }
+    if (acc == NULL) acc = new Accumulator();
+    uint64_t b, w;
+    getBits(BLACK, &b, &w);
+    net->refresh(acc, b, w);
+}
 
-    if(my_tiles > opp_tiles)
-        p = (100.0 * my_tiles)/(my_tiles + opp_tiles);
-    else if(my_tiles < opp_tiles)
-        p = -(100.0 * opp_tiles)/(my_tiles + opp_tiles);
-    else p = 0;
-
-    if(my_front_tiles > opp_front_tiles)
-        f = -(100.0 * my_front_tiles)/(my_front_tiles + opp_front_tiles);
-    else if(my_front_tiles < opp_front_tiles)
-        f = (100.0 * opp_front_tiles)/(my_front_tiles + opp_front_tiles);
-    else f = 0;
-
-    // Corner occupancy
-    my_tiles = opp_tiles = 0;
-    if(get(side, 0, 0)) my_tiles++;
-    else if(occupied(0, 0)) opp_tiles++;
-    if(get(side, 0, 7)) my_tiles++;
-    else if(occupied(0, 7)) opp_tiles++;
-    if(get(side, 7, 0)) my_tiles++;
-    else if(occupied(7, 0)) opp_tiles++;
-    if(get(side, 7, 7)) my_tiles++;
-    else if(occupied(7, 7)) opp_tiles++;
-    c = 25 * (my_tiles - opp_tiles);
-
-// Corner closeness
-    my_tiles = opp_tiles = 0;
-    if(!occupied(0, 0))   {
-        if(get(side, 0, 1)) my_tiles++;
-        else if(occupied(0,1)) opp_tiles++;
-        if(get(side, 1, 1)) my_tiles++;
-        else if(occupied(1, 1)) opp_tiles++;
-        if(get(side, 1, 0)) my_tiles++;
-        else if(occupied(1,0)) opp_tiles++;
-    }
-    if(!occupied(0, 7))   {
-        if(get(side, 0, 6)) my_tiles++;
-        else if(occupied(0, 6)) opp_tiles++;
-        if(get(side, 1, 6)) my_tiles++;
-        else if(occupied(1, 6)) opp_tiles++;
-        if(get(side, 1, 7)) my_tiles++;
-        else if(occupied(1, 7)) opp_tiles++;
-    }
-    if(!occupied(7, 0))   {
-        if(get(side, 7, 1)) my_tiles++;
-        else if(occupied(7, 1)) opp_tiles++;
-        if(get(side, 6, 1)) my_tiles++;
-        else if(occupied(6, 1)) opp_tiles++;
-        if(get(side, 6, 0)) my_tiles++;
-        else if(occupied(6, 0)) opp_tiles++;
-    }
-    if(!occupied(7, 7))   {
-        if(get(side, 6, 7)) my_tiles++;
-        else if(occupied(6, 7)) opp_tiles++;
-        if(get(side, 6, 6)) my_tiles++;
-        else if(occupied(6, 6)) opp_tiles++;
-        if(get(side, 7, 6)) my_tiles++;
-        else if(occupied(7, 6)) opp_tiles++;
-    }
-    l = -12.5 * (my_tiles - opp_tiles);
-
-    // Mobility
-    Side other;
-
-    if(side == WHITE)
-        other = BLACK;
-    else
-        other = WHITE;
-
-    my_tiles = this->numValidMoves(side);
-    opp_tiles = this->numValidMoves(other);
-    if(my_tiles > opp_tiles)
-        m = (100.0 * my_tiles)/(my_tiles + opp_tiles);
-    else if(my_tiles < opp_tiles)
-        m = -(100.0 * opp_tiles)/(my_tiles + opp_tiles);
-    else m = 0;
-
-    // final weighted score
-    double score = (10 * p) + (801.724 * c) + (382.026 * l) + (78.922 * m) + (74.396 * f) + (10 * d);
-    return score;
+/*
+ * Network score of the board for the given side; needs an attached network.
+ */
+double Board::networkEvaluation(Side side) {
+    double score = net->evaluate(acc);
+    return (side == BLACK) ? score : -score;
 }
@@ -2,7 +2,9 @@
 #define __BOARD_H__
 
 #include <bitset>
+#include <stdint.h>
 #include "common.h"
+#include "nnue.h"
 using namespace std;
 
 class Board {
@@ -10,6 +12,8 @@ class Board {
 private:
     bitset<64> black;
     bitset<64> taken;    
+    const Network *net;
+    Accumulator *acc;    // only while a network is attached
        
     bool occupied(int x, int y);
     bool get(Side side, int x, int y);
@@ -32,10 +36,15 @@ public:
     int numValidMoves(Side side);
 
     void setBoard(char data[]);
+    void getBits(Side side, uint64_t *mine, uint64_t *theirs);
+    void setBits(Side side, uint64_t mine, uint64_t theirs);
     std::vector<Move> getAllMoves(Side s);
    
     double dynamic_heuristic_evaluation_function(Side side);
 
+    void setNetwork(const Network *network);
+    double networkEvaluation(Side side);
+
 
 };
 
@@ -0,0 +1,346 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bitboard.h"
+#include "search.h"
+using namespace std;
+
+/*
+ * Builds an opening book. The opening tree is expanded to a fixed ply and
+ * symmetric positions are merged by their canonical form. The positions at
+ * the last ply (and any finished games before it) are searched by a pool
+ * of worker processes that talk to the coordinator over pipes. Every
+ * result is appended to a checkpoint file as it arrives, so an interrupted
+ * build resumes where it stopped. The checkpoint starts with the search
+ * depth, and a build at another depth refuses to resume from it. Scores
+ * are then backed up the tree by minimax, and every position is written
+ * out as
+ *
+ *     <mine> <theirs> <best move> <score>
+ *
+ * with the canonical bitboards in hex, seen from the side to move. The
+ * best move is a square of the canonical position, or 64 for a pass.
+ */
+
+typedef pair<uint64_t, uint64_t> Position;
+
+struct BookNode {
+    int ply;
+    bool leaf;
+    bool done;
+    int move;
+    double score;
+};
+
+struct Worker {
+    pid_t pid;
+    FILE *to;
+    FILE *from;
+    bool busy;
+};
+
+static Position canonical(uint64_t mine, uint64_t theirs) {
+    bbCanonical(&mine, &theirs);
+    return Position(mine, theirs);
+}
+
+/*
+ * Children of a position, in its own (canonical) frame: one per legal
+ * move, or a single pass. Empty if the game is over.
+ */
+static void children(Position p, vector<int> *moves, vector<Position> *next) {
+    moves->clear();
+    next->clear();
+
+    uint64_t legal = bbMoves(p.first, p.second);
+    for (; legal; legal &= legal - 1) {
+        uint64_t m = p.first;
+        uint64_t t = p.second;
+        bbDoMove(&m, &t, bbFirst(legal));
+        moves->push_back(bbFirst(legal));
+        next->push_back(canonical(m, t));
+    }
+    if (moves->empty() && bbMoves(p.second, p.first) != 0) {
+        moves->push_back(PASS_MOVE);
+        next->push_back(canonical(p.second, p.first));
+    }
+}
+
+/*
+ * Body of a worker process: searches each "<mine> <theirs> <depth>" line
+ * read from fd in and answers "<mine> <theirs> <move> <score>" on fd out.
+ */
+static void runWorker(int in, int out) {
+    FILE *requests = fdopen(in, "r");
+    FILE *replies = fdopen(out, "w");
+    Search search;
+
+    unsigned long long mine, theirs;
+    int depth;
+    while (fscanf(requests, "%llx %llx %d", &mine, &theirs, &depth) == 3) {
+        double score;
+        int move = search.search(mine, theirs, depth, &score);
+        fprintf(replies, "%016llx %016llx %d %.3f\n", mine, theirs, move, score);
+        fflush(replies);
+    }
+}
+
+/*
+ * Forks a worker process connected to the coordinator by two pipes.
+ * Pipes of the workers started earlier are closed in the child, so that
+ * each worker sees end of file as soon as the coordinator is done.
+ */
+static Worker startWorker(const vector<Worker> &others) {
+    int down[2], up[2];
+    if (pipe(down) != 0 || pipe(up) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+
+    Worker w;
+    w.pid = fork();
+    if (w.pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (w.pid == 0) {
+        for (int i = 0; i < (int)others.size(); i++) {
+            fclose(others[i].to);
+            fclose(others[i].from);
+        }
+        close(down[1]);
+        close(up[0]);
+        runWorker(down[0], up[1]);
+        _exit(0);
+    }
+
+    close(down[0]);
+    close(up[1]);
+    w.to = fdopen(down[1], "w");
+    w.from = fdopen(up[0], "r");
+    w.busy = false;
+    return w;
+}
+
+static void sendJob(Worker *w, Position p, int depth) {
+    fprintf(w->to, "%016llx %016llx %d\n", (unsigned long long)p.first,
+        (unsigned long long)p.second, depth);
+    fflush(w->to);
+    w->busy = true;
+}
+
+/*
+ * Parses one result line into the tree. Returns false if the line is
+ * malformed or names a position that is not a leaf of this tree.
+ */
+static bool readResult(const char *line, map<Position, BookNode> *tree) {
+    unsigned long long mine, theirs;
+    int move;
+    double score;
+    if (sscanf(line, "%llx %llx %d %lf", &mine, &theirs, &move, &score) != 4) return false;
+
+    map<Position, BookNode>::iterator it = tree->find(Position(mine, theirs));
+    if (it == tree->end() || !it->second.leaf) return false;
+    it->second.done = true;
+    it->second.move = move;
+    it->second.score = score;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int plies = 6;
+    int depth = 10;
+    int numWorkers = thread::hardware_concurrency();
+    const char *checkpoint = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:d:j:c:")) != -1) {
+        switch (opt) {
+            case 'p': plies = atoi(optarg); break;
+            case 'd': depth = atoi(optarg); break;
+            case 'j': numWorkers = atoi(optarg); break;
+            case 'c': checkpoint = optarg; break;
+            default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-p plies] [-d depth] [-j workers] "
+            "[-c checkpoint] book\n", argv[0]);
+        return 1;
+    }
+    if (numWorkers < 1) numWorkers = 1;
+
+    // Expand the opening tree breadth first, merging symmetric positions.
+    map<Position, BookNode> tree;
+    vector<vector<Position> > levels(plies + 1);
+    levels[0].push_back(canonical(0x0000000810000000ULL, 0x0000001008000000ULL));
+
+    vector<int> moves;
+    vector<Position> next;
+    for (int ply = 0; ply <= plies; ply++) {
+        for (int i = 0; i < (int)levels[ply].size(); i++) {
+            Position p = levels[ply][i];
+            BookNode node;
+            node.ply = ply;
+            node.done = false;
+            node.move = PASS_MOVE;
+            node.score = 0;
+
+            children(p, &moves, &next);
+            node.leaf = (ply == plies || moves.empty());
+            tree[p] = node;
+            if (node.leaf) continue;
+
+            for (int j = 0; j < (int)next.size(); j++) {
+                if (tree.count(next[j])) continue;
+                tree[next[j]].ply = ply + 1;    // completed when its ply is expanded
+                levels[ply + 1].push_back(next[j]);
+            }
+        }
+        fprintf(stderr, "ply %d: %d positions\n", ply, (int)levels[ply].size());
+    }
+
+    // Pick up the results of an earlier, interrupted run.
+    int resumed = 0;
+    bool header = false;
+    long complete = 0;
+    FILE *log = NULL;
+    if (checkpoint != NULL) {
+        FILE *f = fopen(checkpoint, "r");
+        if (f != NULL) {
+            char line[256];
+            while (fgets(line, sizeof(line), f)) {
+                // The last line of an interrupted run may be cut short, even
+                // inside the score, and must not count as a result.
+                if (line[strlen(line) - 1] != '\n') break;
+                complete = ftell(f);
+
+                int d;
+                if (!header) {
+                    if (sscanf(line, "# bookbuild depth %d", &d) != 1) {
+                        fprintf(stderr, "%s has no depth header\n", checkpoint);
+                        return 1;
+                    }
+                    if (d != depth) {
+                        fprintf(stderr, "%s holds results searched at depth %d, not %d\n",
+                            checkpoint, d, depth);
+                        return 1;
+                    }
+                    header = true;
+                } else if (readResult(line, &tree)) {
+                    resumed++;
+                }
+            }
+            fclose(f);
+
+            // Cut off a torn last line, so that new results don't complete it.
+            if (header && truncate(checkpoint, complete) != 0) {
+                perror(checkpoint);
+                return 1;
+            }
+        }
+        fprintf(stderr, "resumed %d results from %s\n", resumed, checkpoint);
+    }
+
+    vector<Position> todo;
+    for (map<Position, BookNode>::iterator it = tree.begin(); it != tree.end(); ++it) {
+        if (it->second.leaf && !it->second.done) todo.push_back(it->first);
+    }
+
+    // Search the remaining leaves on the worker processes.
+    vector<Worker> workers;
+    for (int i = 0; i < numWorkers && i < (int)todo.size(); i++) {
+        workers.push_back(startWorker(workers));
+    }
+    if (checkpoint != NULL) {
+        log = fopen(checkpoint, header ? "a" : "w");
+        if (log == NULL) {
+            perror(checkpoint);
+            return 1;
+        }
+        if (!header) fprintf(log, "# bookbuild depth %d\n", depth);
+        fflush(log);
+    }
+
+    size_t sent = 0, received = 0;
+    for (int i = 0; i < (int)workers.size(); i++) sendJob(&workers[i], todo[sent++], depth);
+
+    while (received < sent) {
+        vector<struct pollfd> fds(workers.size());
+        for (int i = 0; i < (int)workers.size(); i++) {
+            fds[i].fd = fileno(workers[i].from);
+            fds[i].events = workers[i].busy ? POLLIN : 0;
+            fds[i].revents = 0;
+        }
+        if (poll(&fds[0], fds.size(), -1) < 0) {
+            perror("poll");
+            return 1;
+        }
+
+        for (int i = 0; i < (int)workers.size(); i++) {
+            if (!workers[i].busy || fds[i].revents == 0) continue;
+
+            // Each worker has one job in flight, so a whole line is coming.
+            char line[256];
+            if (!fgets(line, sizeof(line), workers[i].from) || !readResult(line, &tree)) {
+                fprintf(stderr, "worker %d failed; rerun to resume\n", (int)workers[i].pid);
+                return 1;
+            }
+            if (log != NULL) {
+                fputs(line, log);
+                fflush(log);
+            }
+            workers[i].busy = false;
+            if (++received % 1000 == 0 || received == todo.size()) {
+                fprintf(stderr, "searched %d/%d positions\n", (int)received, (int)todo.size());
+            }
+            if (sent < todo.size()) sendJob(&workers[i], todo[sent++], depth);
+        }
+    }
+
+    for (int i = 0; i < (int)workers.size(); i++) {
+        fclose(workers[i].to);
+        fclose(workers[i].from);
+        waitpid(workers[i].pid, NULL, 0);
+    }
+    if (log != NULL) fclose(log);
+
+    // Back the scores up the tree, deepest plies first.
+    for (int ply = plies - 1; ply >= 0; ply--) {
+        for (int i = 0; i < (int)levels[ply].size(); i++) {
+            BookNode *node = &tree[levels[ply][i]];
+            if (node->leaf) continue;
+
+            children(levels[ply][i], &moves, &next);
+            node->score = -2 * SEARCH_WIN;
+            for (int j = 0; j < (int)next.size(); j++) {
+                double v = -tree[next[j]].score;
+                if (v > node->score) {
+                    node->score = v;
+                    node->move = moves[j];
+                }
+            }
+            node->done = true;
+        }
+    }
+
+    FILE *out = fopen(argv[optind], "w");
+    if (out == NULL) {
+        perror(argv[optind]);
+        return 1;
+    }
+    for (map<Position, BookNode>::iterator it = tree.begin(); it != tree.end(); ++it) {
+        fprintf(out, "%016llx %016llx %d %.3f\n", (unsigned long long)it->first.first,
+            (unsigned long long)it->first.second, it->second.move, it->second.score);
+    }
+    fclose(out);
+    fprintf(stderr, "wrote %d positions to %s\n", (int)tree.size(), argv[optind]);
+    return 0;
+}
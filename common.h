@@ -8,6 +8,11 @@ enum Side {
     WHITE, BLACK
 };
 
+// Search engine a Player uses to pick its moves.
+enum Engine {
+    ALPHA_BETA, MONTE_CARLO
+};
+
 class Move {
    
 public:
@@ -0,0 +1,214 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "bitboard.h"
+#include "search.h"
+using namespace std;
+
+/*
+ * Endgame test-suite benchmark. Each line of a positions file is
+ *
+ *     <64 squares> <side to move> <score> <best moves>
+ *
+ * in FFO style: the squares run a1 b1 ... h1 a2 ... h8 with 'X' for black,
+ * 'O' for white and '-' for empty, the side is 'X' or 'O', the score is the
+ * exact final disc differential for the side to move and the best moves
+ * are all moves reaching it, comma separated ("g8,a1"). Blank lines and
+ * lines starting with '#' are skipped.
+ *
+ * Every position is solved and checked. Wall time, nodes, nodes/sec and
+ * time and nodes to solution (when the root settled on its final move) are
+ * printed per position and in total. With -r the same figures are written to a
+ * report file; -c prints two such reports, e.g. from two builds, side by
+ * side. The exit status is nonzero if any position was solved wrongly.
+ */
+
+struct Entry {
+    int empties;
+    bool ok;
+    double ms;
+    long long nodes;
+    double msToBest;
+    long long nodesToBest;
+};
+
+static string squareName(int sq) {
+    if (sq == PASS_MOVE) return "pass";
+    string name = "a1";
+    name[0] += sq % 8;
+    name[1] += sq / 8;
+    return name;
+}
+
+/*
+ * Parses one position line. Returns false if it is not a position.
+ */
+static bool parsePosition(const char *line, uint64_t *mine, uint64_t *theirs,
+                          int *score, string *moves) {
+    char squares[65], side[2], best[256];
+    if (sscanf(line, "%64s %1s %d %255s", squares, side, score, best) != 4) return false;
+    if (strlen(squares) != 64) return false;
+
+    uint64_t black = 0, white = 0;
+    for (int i = 0; i < 64; i++) {
+        if (squares[i] == 'X') black |= 1ULL << i;
+        else if (squares[i] == 'O') white |= 1ULL << i;
+        else if (squares[i] != '-') return false;
+    }
+    *mine = (side[0] == 'X') ? black : white;
+    *theirs = (side[0] == 'X') ? white : black;
+    *moves = string(",") + best + ",";
+    return true;
+}
+
+static bool readReport(const char *path, vector<Entry> *entries) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        Entry e;
+        int n, ok;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%d %d %d %lf %lld %lf %lld", &n, &e.empties, &ok, &e.ms,
+                   &e.nodes, &e.msToBest, &e.nodesToBest) != 7) continue;
+        e.ok = ok;
+        entries->push_back(e);
+    }
+    fclose(f);
+    return true;
+}
+
+static double rate(long long nodes, double ms) {
+    return (ms > 0) ? nodes / ms : 0;
+}
+
+/*
+ * Prints two reports of the same suite side by side.
+ */
+static int compare(const char *pathA, const char *pathB) {
+    vector<Entry> a, b;
+    if (!readReport(pathA, &a) || !readReport(pathB, &b)) return 1;
+    if (a.size() != b.size()) {
+        fprintf(stderr, "%s and %s cover different numbers of positions\n", pathA, pathB);
+        return 1;
+    }
+
+    printf("A: %s\nB: %s\n", pathA, pathB);
+    printf("%4s %4s %10s %10s %7s %12s %12s %9s %9s %12s %12s\n", "#", "emp", "A ms",
+        "B ms", "B/A", "A nodes", "B nodes", "A kn/s", "B kn/s", "A tts nodes",
+        "B tts nodes");
+
+    double msA = 0, msB = 0;
+    long long nodesA = 0, nodesB = 0, toBestA = 0, toBestB = 0;
+    for (int i = 0; i < (int)a.size(); i++) {
+        printf("%4d %4d %10.1f %10.1f %7.2f %12lld %12lld %9.0f %9.0f %12lld %12lld%s\n",
+            i + 1, a[i].empties, a[i].ms, b[i].ms, (a[i].ms > 0) ? b[i].ms / a[i].ms : 0,
+            a[i].nodes, b[i].nodes, rate(a[i].nodes, a[i].ms), rate(b[i].nodes, b[i].ms),
+            a[i].nodesToBest, b[i].nodesToBest, (a[i].ok && b[i].ok) ? "" : "  FAILED");
+        msA += a[i].ms;
+        msB += b[i].ms;
+        nodesA += a[i].nodes;
+        nodesB += b[i].nodes;
+        toBestA += a[i].nodesToBest;
+        toBestB += b[i].nodesToBest;
+    }
+    printf("%9s %10.1f %10.1f %7.2f %12lld %12lld %9.0f %9.0f %12lld %12lld\n", "total",
+        msA, msB, (msA > 0) ? msB / msA : 0, nodesA, nodesB, rate(nodesA, msA),
+        rate(nodesB, msB), toBestA, toBestB);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *reportPath = NULL;
+    const char *comparePath = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:c:")) != -1) {
+        switch (opt) {
+            case 'r': reportPath = optarg; break;
+            case 'c': comparePath = optarg; break;
+            default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-r report] positions\n"
+            "       %s -c report1 report2\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (comparePath != NULL) return compare(comparePath, argv[optind]);
+
+    FILE *in = fopen(argv[optind], "r");
+    if (in == NULL) {
+        perror(argv[optind]);
+        return 1;
+    }
+    FILE *report = NULL;
+    if (reportPath != NULL) {
+        report = fopen(reportPath, "w");
+        if (report == NULL) {
+            perror(reportPath);
+            return 1;
+        }
+        fprintf(report, "# endgamebench %s\n# n empties ok ms nodes ms-to-best nodes-to-best\n",
+            argv[optind]);
+    }
+
+    printf("%4s %4s %5s %5s %5s %4s %10s %12s %9s %10s %12s\n", "#", "emp", "score", "want",
+        "move", "ok", "ms", "nodes", "kn/s", "tts ms", "tts nodes");
+
+    Search search;
+    char line[512];
+    int n = 0, failed = 0;
+    double totalMs = 0, totalToBest = 0;
+    long long totalNodes = 0, totalNodesToBest = 0;
+    while (fgets(line, sizeof(line), in)) {
+        uint64_t mine, theirs;
+        int expected;
+        string bestMoves;
+        if (line[0] == '#' || !parsePosition(line, &mine, &theirs, &expected, &bestMoves)) continue;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        int score;
+        int move = search.solve(mine, theirs, &score);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        Entry e;
+        e.empties = 64 - bbCount(mine | theirs);
+        e.ok = (score == expected)
+            && bestMoves.find("," + squareName(move) + ",") != string::npos;
+        e.ms = ms;
+        e.nodes = search.nodes;
+        e.msToBest = search.msToBest;
+        e.nodesToBest = search.nodesToBest;
+
+        n++;
+        printf("%4d %4d %+5d %+5d %5s %4s %10.1f %12lld %9.0f %10.1f %12lld\n", n,
+            e.empties, score, expected, squareName(move).c_str(), e.ok ? "yes" : "NO", e.ms,
+            e.nodes, rate(e.nodes, e.ms), e.msToBest, e.nodesToBest);
+        fflush(stdout);
+        if (report != NULL) {
+            fprintf(report, "%d %d %d %.3f %lld %.3f %lld\n", n, e.empties, e.ok, e.ms,
+                e.nodes, e.msToBest, e.nodesToBest);
+        }
+
+        if (!e.ok) failed++;
+        totalMs += e.ms;
+        totalNodes += e.nodes;
+        totalToBest += e.msToBest;
+        totalNodesToBest += e.nodesToBest;
+    }
+    fclose(in);
+    if (report != NULL) fclose(report);
+
+    printf("%d positions, %d failed: %.1f ms, %lld nodes, %.0f kn/s, "
+        "%.1f ms and %lld nodes to solution\n", n, failed, totalMs, totalNodes,
+        rate(totalNodes, totalMs), totalToBest, totalNodesToBest);
+    return (failed > 0) ? 1 : 0;
+}
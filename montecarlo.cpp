@@ -0,0 +1,339 @@
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "montecarlo.h"
+
+using namespace std;
+
+enum { UNEXPANDED, EXPANDING, EXPANDED };
+
+// Nodes per arena; two arenas are allocated so the tree can be compacted.
+#define ARENA_NODES (1 << 22)
+
+// Visits added to every node on the path while a playout is in flight, so
+// that other threads are steered towards different branches.
+#define VIRTUAL_LOSS 3
+
+// UCT exploration constant, for rewards in [0, 1].
+#define EXPLORATION 1.0
+
+// Longest possible path: 60 moves plus a pass before each of them.
+#define MAX_PATH 128
+
+/*
+ * Creates a searcher that runs the given number of threads.
+ */
+MonteCarlo::MonteCarlo(int threads) {
+    numThreads = (threads < 1) ? 1 : threads;
+    capacity = ARENA_NODES;
+    arena = new MonteCarloNode[capacity];
+    spare = new MonteCarloNode[capacity];
+    playouts = 0;
+    msUsed = 0;
+    reset(0, 0);
+}
+
+/*
+ * Destructor for the searcher.
+ */
+MonteCarlo::~MonteCarlo() {
+    delete[] arena;
+    delete[] spare;
+}
+
+static void initNode(MonteCarloNode *node, int move) {
+    node->visits.store(0, memory_order_relaxed);
+    node->wins.store(0, memory_order_relaxed);
+    node->state.store(UNEXPANDED, memory_order_relaxed);
+    node->move = move;
+    node->numChildren = 0;
+    node->firstChild = 0;
+}
+
+static void copyNode(MonteCarloNode *dst, MonteCarloNode *src) {
+    dst->visits.store(src->visits.load(memory_order_relaxed), memory_order_relaxed);
+    dst->wins.store(src->wins.load(memory_order_relaxed), memory_order_relaxed);
+    dst->state.store(src->state.load(memory_order_relaxed), memory_order_relaxed);
+    dst->move = src->move;
+    dst->numChildren = src->numChildren;
+    dst->firstChild = src->firstChild;
+}
+
+static inline uint64_t nextRandom(uint64_t *rng) {
+    // xorshift64*
+    *rng ^= *rng >> 12;
+    *rng ^= *rng << 25;
+    *rng ^= *rng >> 27;
+    return *rng * 2685821657736338717ULL;
+}
+
+/*
+ * Discards the whole tree and starts a new one at the given position.
+ */
+void MonteCarlo::reset(uint64_t mine, uint64_t theirs) {
+    initNode(&arena[0], PASS_MOVE);
+    used.store(1);
+    full.store(false);
+    rootMine = mine;
+    rootTheirs = theirs;
+}
+
+/*
+ * Makes the tree's root match the given position, keeping the statistics
+ * gathered so far. This works if the position is the root itself or one of
+ * its children, which is the case after our move plus the opponent's reply.
+ */
+bool MonteCarlo::findRoot(uint64_t mine, uint64_t theirs) {
+    if (rootMine == mine && rootTheirs == theirs) return true;
+
+    MonteCarloNode *root = &arena[0];
+    if (root->state.load() != EXPANDED) return false;
+
+    for (int i = 0; i < root->numChildren; i++) {
+        uint32_t child = root->firstChild + i;
+        uint64_t m = rootMine;
+        uint64_t t = rootTheirs;
+        bbDoMove(&m, &t, arena[child].move);
+        if (m == mine && t == theirs) {
+            promote(child);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Makes a child of the root the new root. Its subtree is copied breadth
+ * first into the spare arena, which then becomes the live one; every
+ * other node is dropped. Must not run while a search is in progress.
+ */
+void MonteCarlo::promote(uint32_t child) {
+    bbDoMove(&rootMine, &rootTheirs, arena[child].move);
+
+    copyNode(&spare[0], &arena[child]);
+    uint32_t next = 1;
+    for (uint32_t i = 0; i < next; i++) {
+        MonteCarloNode *node = &spare[i];
+        if (node->state.load(memory_order_relaxed) != EXPANDED) continue;
+
+        // firstChild still points into the old arena at this point.
+        uint32_t src = node->firstChild;
+        node->firstChild = next;
+        for (int j = 0; j < node->numChildren; j++) {
+            copyNode(&spare[next++], &arena[src + j]);
+        }
+    }
+
+    MonteCarloNode *tmp = arena;
+    arena = spare;
+    spare = tmp;
+    used.store(next);
+    full.store(false);
+}
+
+/*
+ * Gives node n one child per legal move (or a single pass child). Returns
+ * false if another thread got there first or the arena is exhausted.
+ */
+bool MonteCarlo::expand(uint32_t n, uint64_t mine, uint64_t theirs) {
+    MonteCarloNode *node = &arena[n];
+    if (full.load(memory_order_relaxed)) return false;
+
+    char expected = UNEXPANDED;
+    if (!node->state.compare_exchange_strong(expected, EXPANDING)) return false;
+
+    uint64_t moves = bbMoves(mine, theirs);
+    int count = bbCount(moves);
+    if (count == 0 && bbMoves(theirs, mine) != 0) count = 1;
+
+    uint32_t first = used.fetch_add(count);
+    if (first + count > capacity) {
+        full.store(true);
+        node->state.store(UNEXPANDED);
+        return false;
+    }
+
+    if (moves == 0 && count == 1) {
+        initNode(&arena[first], PASS_MOVE);
+    }
+    for (int i = 0; moves; i++, moves &= moves - 1) {
+        initNode(&arena[first + i], bbFirst(moves));
+    }
+
+    node->firstChild = first;
+    node->numChildren = count;
+    node->state.store(EXPANDED, memory_order_release);
+    return true;
+}
+
+/*
+ * Picks the child with the highest UCT value. Unvisited children come
+ * first; virtual losses count as visits that scored nothing.
+ */
+uint32_t MonteCarlo::select(MonteCarloNode *node) {
+    double logN = log((double)node->visits.load(memory_order_relaxed));
+    double max = -1.e20;
+    uint32_t best = node->firstChild;
+
+    for (int i = 0; i < node->numChildren; i++) {
+        MonteCarloNode *child = &arena[node->firstChild + i];
+        int v = child->visits.load(memory_order_relaxed);
+        if (v == 0) return node->firstChild + i;
+
+        double q = child->wins.load(memory_order_relaxed) / (2.0 * v);
+        double uct = q + EXPLORATION * sqrt(logN / v);
+        if (uct > max) {
+            max = uct;
+            best = node->firstChild + i;
+        }
+    }
+    return best;
+}
+
+/*
+ * Plays random moves to the end of the game. Returns half-points for the
+ * side to move at the start: 2 for a win, 1 for a draw, 0 for a loss.
+ */
+int MonteCarlo::playout(uint64_t mine, uint64_t theirs, uint64_t *rng) {
+    bool swapped = false;
+
+    for (;;) {
+        uint64_t moves = bbMoves(mine, theirs);
+        if (moves == 0) {
+            if (bbMoves(theirs, mine) == 0) break;
+            bbDoMove(&mine, &theirs, PASS_MOVE);
+            swapped = !swapped;
+            continue;
+        }
+
+        int k = nextRandom(rng) % bbCount(moves);
+        while (k--) moves &= moves - 1;
+        bbDoMove(&mine, &theirs, bbFirst(moves));
+        swapped = !swapped;
+    }
+
+    int diff = bbCount(mine) - bbCount(theirs);
+    if (swapped) diff = -diff;
+    return (diff > 0) ? 2 : (diff == 0) ? 1 : 0;
+}
+
+/*
+ * One select / expand / playout / backup cycle from the root.
+ */
+void MonteCarlo::iterate(uint64_t *rng) {
+    uint32_t path[MAX_PATH];
+    int len = 0;
+    uint64_t mine = rootMine;
+    uint64_t theirs = rootTheirs;
+
+    uint32_t n = 0;
+    int prev = arena[n].visits.fetch_add(VIRTUAL_LOSS, memory_order_relaxed);
+    path[len++] = n;
+
+    for (;;) {
+        MonteCarloNode *node = &arena[n];
+        char state = node->state.load(memory_order_acquire);
+
+        // Leaves are expanded the second time they are reached.
+        if (state == UNEXPANDED && (prev > 0 || n == 0)) {
+            if (expand(n, mine, theirs)) state = EXPANDED;
+        }
+        if (state != EXPANDED || node->numChildren == 0) break;
+
+        n = select(node);
+        bbDoMove(&mine, &theirs, arena[n].move);
+        prev = arena[n].visits.fetch_add(VIRTUAL_LOSS, memory_order_relaxed);
+        path[len++] = n;
+    }
+
+    // The leaf is credited to the side that moved into it.
+    int result = 2 - playout(mine, theirs, rng);
+    for (int i = len - 1; i >= 0; i--) {
+        arena[path[i]].wins.fetch_add(result, memory_order_relaxed);
+        arena[path[i]].visits.fetch_add(1 - VIRTUAL_LOSS, memory_order_relaxed);
+        result = 2 - result;
+    }
+}
+
+/*
+ * Search loop of a helper thread; runs until stop is raised.
+ */
+void MonteCarlo::work(uint64_t seed, long long *count) {
+    uint64_t rng = seed;
+    long long n = 0;
+    while (!stop.load(memory_order_relaxed)) {
+        iterate(&rng);
+        n++;
+    }
+    *count = n;
+}
+
+/*
+ * Searches the position for about msBudget milliseconds and returns the
+ * most visited move, or PASS_MOVE if the side to move has no legal move.
+ * The tree below the returned move is kept for the next call.
+ */
+int MonteCarlo::search(uint64_t mine, uint64_t theirs, int msBudget) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    chrono::steady_clock::time_point deadline =
+        start + chrono::milliseconds(msBudget);
+
+    if (!findRoot(mine, theirs)) reset(mine, theirs);
+    playouts = 0;
+
+    uint64_t moves = bbMoves(mine, theirs);
+    if (moves == 0) {
+        reset(mine, theirs);
+        msUsed = 0;
+        return PASS_MOVE;
+    }
+
+    // With a single legal move there is nothing to think about.
+    if (bbCount(moves) > 1) {
+        stop.store(false);
+        vector<thread> helpers;
+        vector<long long> counts(numThreads, 0);
+        uint64_t seed = chrono::steady_clock::now().time_since_epoch().count();
+        for (int i = 1; i < numThreads; i++) {
+            helpers.push_back(thread(&MonteCarlo::work, this,
+                seed + 0x9e3779b97f4a7c15ULL * i, &counts[i]));
+        }
+
+        uint64_t rng = seed | 1;
+        long long n = 0;
+        do {
+            for (int i = 0; i < 64; i++) iterate(&rng);
+            n += 64;
+        } while (chrono::steady_clock::now() < deadline);
+
+        stop.store(true);
+        for (int i = 0; i < (int)helpers.size(); i++) helpers[i].join();
+        counts[0] = n;
+        for (int i = 0; i < numThreads; i++) playouts += counts[i];
+    } else {
+        expand(0, mine, theirs);
+    }
+
+    msUsed = chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now() - start).count();
+
+    MonteCarloNode *root = &arena[0];
+    uint32_t best = root->firstChild;
+    for (int i = 1; i < root->numChildren; i++) {
+        uint32_t child = root->firstChild + i;
+        if (arena[child].visits.load() > arena[best].visits.load()) best = child;
+    }
+
+    int move = arena[best].move;
+    promote(best);
+    return move;
+}
+
+/*
+ * Playout rate of the last search.
+ */
+double MonteCarlo::playoutsPerSecond() {
+    if (msUsed <= 0) return 0;
+    return 1000.0 * playouts / msUsed;
+}
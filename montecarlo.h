@@ -0,0 +1,61 @@
+#ifndef __MONTECARLO_H__
+#define __MONTECARLO_H__
+
+#include <atomic>
+#include <stdint.h>
+#include "bitboard.h"
+
+/*
+ * A node of the search tree. Statistics are updated lock-free by every
+ * search thread; the remaining fields are written once, by the thread that
+ * expands the node, before its state is published as EXPANDED.
+ */
+struct MonteCarloNode {
+    std::atomic<int> visits;    // finished playouts plus in-flight virtual losses
+    std::atomic<int> wins;      // half-points for the side that moved into this node
+    std::atomic<char> state;    // UNEXPANDED, EXPANDING or EXPANDED
+    unsigned char move;         // square played to reach this node, or PASS_MOVE
+    unsigned char numChildren;  // zero once expanded means the game is over
+    uint32_t firstChild;        // children are stored contiguously in the arena
+};
+
+/*
+ * Tree-parallel UCT search with random bitboard playouts. Nodes come from
+ * a preallocated arena; after each move the subtree that is still reachable
+ * is compacted into a second arena and searched again on the next call.
+ */
+class MonteCarlo {
+
+private:
+    MonteCarloNode *arena;
+    MonteCarloNode *spare;
+    uint32_t capacity;
+    std::atomic<uint32_t> used;
+    std::atomic<bool> full;
+    std::atomic<bool> stop;
+    int numThreads;
+
+    uint64_t rootMine, rootTheirs;
+
+    void reset(uint64_t mine, uint64_t theirs);
+    bool findRoot(uint64_t mine, uint64_t theirs);
+    void promote(uint32_t child);
+    void work(uint64_t seed, long long *count);
+    void iterate(uint64_t *rng);
+    bool expand(uint32_t n, uint64_t mine, uint64_t theirs);
+    uint32_t select(MonteCarloNode *node);
+    int playout(uint64_t mine, uint64_t theirs, uint64_t *rng);
+
+public:
+    MonteCarlo(int threads);
+    ~MonteCarlo();
+
+    int search(uint64_t mine, uint64_t theirs, int msBudget);
+
+    // Statistics of the last call to search().
+    long long playouts;
+    int msUsed;
+    double playoutsPerSecond();
+};
+
+#endif
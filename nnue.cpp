@@ -0,0 +1,213 @@
+#include <cstdio>
+#include <cstring>
+#include "nnue.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86
+#endif
+
+// Weights file layout: magic, version, the three layer sizes, then w1, b1,
+// w2, b2, w3 and b3 as raw little-endian arrays.
+static const char NNUE_MAGIC[4] = { 'S', 'K', 'N', 'N' };
+static const uint32_t NNUE_VERSION = 1;
+
+/*
+ * Creates a network with every weight set to zero.
+ */
+Network::Network() {
+    memset(w1, 0, sizeof(w1));
+    memset(b1, 0, sizeof(b1));
+    memset(w2, 0, sizeof(w2));
+    memset(b2, 0, sizeof(b2));
+    memset(w3, 0, sizeof(w3));
+    b3 = 0;
+}
+
+/*
+ * Destructor for the network.
+ */
+Network::~Network() {
+}
+
+/*
+ * Reads the weights from a file written by save(). Returns false, leaving
+ * the network unchanged, if the file is missing or of the wrong shape.
+ */
+bool Network::load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    char magic[4];
+    uint32_t header[4];
+    bool ok = fread(magic, 1, 4, f) == 4
+        && fread(header, sizeof(uint32_t), 4, f) == 4
+        && memcmp(magic, NNUE_MAGIC, 4) == 0
+        && header[0] == NNUE_VERSION
+        && header[1] == NNUE_INPUTS
+        && header[2] == NNUE_HIDDEN1
+        && header[3] == NNUE_HIDDEN2;
+
+    Network tmp;
+    ok = ok
+        && fread(tmp.w1, sizeof(w1), 1, f) == 1
+        && fread(tmp.b1, sizeof(b1), 1, f) == 1
+        && fread(tmp.w2, sizeof(w2), 1, f) == 1
+        && fread(tmp.b2, sizeof(b2), 1, f) == 1
+        && fread(tmp.w3, sizeof(w3), 1, f) == 1
+        && fread(&tmp.b3, sizeof(b3), 1, f) == 1;
+    fclose(f);
+
+    if (ok) *this = tmp;
+    return ok;
+}
+
+/*
+ * Writes the weights to a file. Returns false on any I/O error.
+ */
+bool Network::save(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return false;
+
+    uint32_t header[4] = { NNUE_VERSION, NNUE_INPUTS, NNUE_HIDDEN1, NNUE_HIDDEN2 };
+    bool ok = fwrite(NNUE_MAGIC, 1, 4, f) == 4
+        && fwrite(header, sizeof(uint32_t), 4, f) == 4
+        && fwrite(w1, sizeof(w1), 1, f) == 1
+        && fwrite(b1, sizeof(b1), 1, f) == 1
+        && fwrite(w2, sizeof(w2), 1, f) == 1
+        && fwrite(b2, sizeof(b2), 1, f) == 1
+        && fwrite(w3, sizeof(w3), 1, f) == 1
+        && fwrite(&b3, sizeof(b3), 1, f) == 1;
+    return (fclose(f) == 0) && ok;
+}
+
+static inline void addFeature(const Network *net, Accumulator *acc, int feature) {
+    for (int i = 0; i < NNUE_HIDDEN1; i++) acc->values[i] += net->w1[feature][i];
+}
+
+static inline void subFeature(const Network *net, Accumulator *acc, int feature) {
+    for (int i = 0; i < NNUE_HIDDEN1; i++) acc->values[i] -= net->w1[feature][i];
+}
+
+/*
+ * Recomputes the first layer from scratch.
+ */
+void Network::refresh(Accumulator *acc, uint64_t black, uint64_t white) const {
+    memcpy(acc->values, b1, sizeof(b1));
+    for (; black; black &= black - 1) addFeature(this, acc, __builtin_ctzll(black));
+    for (; white; white &= white - 1) addFeature(this, acc, 64 + __builtin_ctzll(white));
+}
+
+/*
+ * Updates the first layer for side playing on sq and flipping the discs
+ * in flips.
+ */
+void Network::make(Accumulator *acc, Side side, int sq, uint64_t flips) const {
+    int mine = (side == BLACK) ? 0 : 64;
+    int theirs = 64 - mine;
+
+    addFeature(this, acc, mine + sq);
+    for (; flips; flips &= flips - 1) {
+        int f = __builtin_ctzll(flips);
+        addFeature(this, acc, mine + f);
+        subFeature(this, acc, theirs + f);
+    }
+}
+
+/*
+ * Reverts a make() with the same arguments.
+ */
+void Network::unmake(Accumulator *acc, Side side, int sq, uint64_t flips) const {
+    int mine = (side == BLACK) ? 0 : 64;
+    int theirs = 64 - mine;
+
+    subFeature(this, acc, mine + sq);
+    for (; flips; flips &= flips - 1) {
+        int f = __builtin_ctzll(flips);
+        subFeature(this, acc, mine + f);
+        addFeature(this, acc, theirs + f);
+    }
+}
+
+static inline int clipped(int x) {
+    return (x < 0) ? 0 : (x > NNUE_ACTIVATION_ONE) ? NNUE_ACTIVATION_ONE : x;
+}
+
+/*
+ * Layers two and three in plain C++, for processors without AVX2.
+ */
+static int32_t forwardScalar(const Network *net, const Accumulator *acc) {
+    uint8_t h1[NNUE_HIDDEN1];
+    for (int i = 0; i < NNUE_HIDDEN1; i++) h1[i] = clipped(acc->values[i]);
+
+    int32_t out = net->b3;
+    for (int j = 0; j < NNUE_HIDDEN2; j++) {
+        int32_t sum = net->b2[j];
+        for (int i = 0; i < NNUE_HIDDEN1; i++) sum += h1[i] * net->w2[j][i];
+        out += clipped(sum / NNUE_WEIGHT_ONE) * net->w3[j];
+    }
+    return out;
+}
+
+#ifdef NNUE_X86
+__attribute__((target("avx2")))
+static inline int32_t sum8(__m256i v) {
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4e));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xb1));
+    return _mm_cvtsi128_si32(x);
+}
+
+/*
+ * Layers two and three with AVX2 u8 x i8 multiply-adds. Gives exactly the
+ * same result as forwardScalar().
+ */
+__attribute__((target("avx2")))
+static int32_t forwardAvx2(const Network *net, const Accumulator *acc) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    // Saturating int16 -> int8 packing clips at 127; packs interleaves the
+    // 128-bit lanes, which the permute puts back in order.
+    const __m256i *a = (const __m256i *)acc->values;
+    __m256i lo = _mm256_packs_epi16(_mm256_loadu_si256(a), _mm256_loadu_si256(a + 1));
+    __m256i hi = _mm256_packs_epi16(_mm256_loadu_si256(a + 2), _mm256_loadu_si256(a + 3));
+    lo = _mm256_max_epi8(_mm256_permute4x64_epi64(lo, 0xd8), zero);
+    hi = _mm256_max_epi8(_mm256_permute4x64_epi64(hi, 0xd8), zero);
+
+    uint8_t h2[NNUE_HIDDEN2];
+    for (int j = 0; j < NNUE_HIDDEN2; j++) {
+        const __m256i *w = (const __m256i *)net->w2[j];
+        __m256i s = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_maddubs_epi16(lo, _mm256_loadu_si256(w)), ones),
+            _mm256_madd_epi16(_mm256_maddubs_epi16(hi, _mm256_loadu_si256(w + 1)), ones));
+        h2[j] = clipped((net->b2[j] + sum8(s)) / NNUE_WEIGHT_ONE);
+    }
+
+    __m256i s = _mm256_madd_epi16(_mm256_maddubs_epi16(
+        _mm256_loadu_si256((const __m256i *)h2),
+        _mm256_loadu_si256((const __m256i *)net->w3)), ones);
+    return net->b3 + sum8(s);
+}
+
+static bool haveAvx2() {
+    static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return avx2;
+}
+#endif
+
+/*
+ * Returns the predicted final disc differential, from black's point of
+ * view, for the position the accumulator describes.
+ */
+double Network::evaluate(const Accumulator *acc) const {
+    int32_t out;
+#ifdef NNUE_X86
+    if (haveAvx2()) out = forwardAvx2(this, acc);
+    else
+#endif
+    out = forwardScalar(this, acc);
+
+    // Output units are NNUE_ACTIVATION_ONE * NNUE_WEIGHT_ONE per 64 discs.
+    return out * 64.0 / (NNUE_ACTIVATION_ONE * NNUE_WEIGHT_ONE);
+}
@@ -0,0 +1,51 @@
+#ifndef __NNUE_H__
+#define __NNUE_H__
+
+#include <stdint.h>
+#include "common.h"
+
+/*
+ * A small quantized network, 128 -> 64 -> 32 -> 1, evaluated on the CPU.
+ * Input feature sq is a black disc on square sq and 64 + sq a white disc.
+ * The first layer is kept in an int16 accumulator that is updated from
+ * the flip mask of each move; the later layers are int8 dot products,
+ * using AVX2 when the processor has it.
+ */
+
+#define NNUE_INPUTS 128
+#define NNUE_HIDDEN1 64
+#define NNUE_HIDDEN2 32
+
+// Activations are clipped to [0, 1], stored as [0, NNUE_ACTIVATION_ONE].
+#define NNUE_ACTIVATION_ONE 127
+// Fixed-point scale of the int8 weights of layers two and three.
+#define NNUE_WEIGHT_ONE 64
+
+struct Accumulator {
+    int16_t values[NNUE_HIDDEN1];
+};
+
+class Network {
+
+public:
+    Network();
+    ~Network();
+
+    bool load(const char *path);
+    bool save(const char *path);
+
+    void refresh(Accumulator *acc, uint64_t black, uint64_t white) const;
+    void make(Accumulator *acc, Side side, int sq, uint64_t flips) const;
+    void unmake(Accumulator *acc, Side side, int sq, uint64_t flips) const;
+    double evaluate(const Accumulator *acc) const;
+
+    // Quantized parameters, as stored in the weights file.
+    int16_t w1[NNUE_INPUTS][NNUE_HIDDEN1];
+    int16_t b1[NNUE_HIDDEN1];
+    int8_t w2[NNUE_HIDDEN2][NNUE_HIDDEN1];
+    int32_t b2[NNUE_HIDDEN2];
+    int8_t w3[NNUE_HIDDEN2];
+    int32_t b3;
+};
+
+#endif
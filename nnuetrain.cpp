@@ -0,0 +1,210 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "nnue.h"
+using namespace std;
+
+/*
+ * Trains the network on positions written by selfplay and saves the
+ * quantized weights. Training is plain SGD on a float copy of the network
+ * with the same shape and clipped activations; weights are kept inside the
+ * range the quantized format can hold. The target is the game's final
+ * disc differential, from black's point of view, divided by 64.
+ */
+
+struct Sample {
+    uint64_t black, white;
+    float target;
+};
+
+static float W1[NNUE_INPUTS][NNUE_HIDDEN1], B1[NNUE_HIDDEN1];
+static float W2[NNUE_HIDDEN2][NNUE_HIDDEN1], B2[NNUE_HIDDEN2];
+static float W3[NNUE_HIDDEN2], B3;
+
+// Largest weights the int16 / int8 quantized layers can represent.
+#define MAX_W1 2.0f
+#define MAX_W23 (127.0f / NNUE_WEIGHT_ONE)
+
+static float uniform(float range) {
+    return range * (2.0f * rand() / RAND_MAX - 1.0f);
+}
+
+static float clip(float x, float lo, float hi) {
+    return (x < lo) ? lo : (x > hi) ? hi : x;
+}
+
+static int features(const Sample &s, int *active) {
+    int n = 0;
+    for (uint64_t b = s.black; b; b &= b - 1) active[n++] = __builtin_ctzll(b);
+    for (uint64_t w = s.white; w; w &= w - 1) active[n++] = 64 + __builtin_ctzll(w);
+    return n;
+}
+
+/*
+ * Runs one sample forward and, if lr > 0, back-propagates its squared
+ * error. Returns the squared error.
+ */
+static float step(const Sample &s, float lr) {
+    int active[64];
+    int n = features(s, active);
+
+    float a1[NNUE_HIDDEN1], h1[NNUE_HIDDEN1];
+    for (int j = 0; j < NNUE_HIDDEN1; j++) a1[j] = B1[j];
+    for (int f = 0; f < n; f++) {
+        for (int j = 0; j < NNUE_HIDDEN1; j++) a1[j] += W1[active[f]][j];
+    }
+    for (int j = 0; j < NNUE_HIDDEN1; j++) h1[j] = clip(a1[j], 0, 1);
+
+    float a2[NNUE_HIDDEN2], h2[NNUE_HIDDEN2];
+    float y = B3;
+    for (int k = 0; k < NNUE_HIDDEN2; k++) {
+        a2[k] = B2[k];
+        for (int j = 0; j < NNUE_HIDDEN1; j++) a2[k] += W2[k][j] * h1[j];
+        h2[k] = clip(a2[k], 0, 1);
+        y += W3[k] * h2[k];
+    }
+
+    float err = y - s.target;
+    if (lr <= 0) return err * err;
+
+    float dy = 2 * err;
+    float da1[NNUE_HIDDEN1];
+    memset(da1, 0, sizeof(da1));
+    for (int k = 0; k < NNUE_HIDDEN2; k++) {
+        float da2 = (a2[k] > 0 && a2[k] < 1) ? dy * W3[k] : 0;
+        W3[k] = clip(W3[k] - lr * dy * h2[k], -MAX_W23, MAX_W23);
+        if (da2 == 0) continue;
+        for (int j = 0; j < NNUE_HIDDEN1; j++) {
+            da1[j] += da2 * W2[k][j];
+            W2[k][j] = clip(W2[k][j] - lr * da2 * h1[j], -MAX_W23, MAX_W23);
+        }
+        B2[k] -= lr * da2;
+    }
+    B3 -= lr * dy;
+
+    for (int j = 0; j < NNUE_HIDDEN1; j++) {
+        if (a1[j] <= 0 || a1[j] >= 1) da1[j] = 0;
+        B1[j] -= lr * da1[j];
+    }
+    for (int f = 0; f < n; f++) {
+        float *w = W1[active[f]];
+        for (int j = 0; j < NNUE_HIDDEN1; j++) w[j] = clip(w[j] - lr * da1[j], -MAX_W1, MAX_W1);
+    }
+    return err * err;
+}
+
+/*
+ * Rounds the float weights into the network's fixed-point format.
+ */
+static void quantize(Network *net) {
+    const float A = NNUE_ACTIVATION_ONE;
+    const float W = NNUE_WEIGHT_ONE;
+
+    for (int j = 0; j < NNUE_HIDDEN1; j++) {
+        net->b1[j] = lrintf(B1[j] * A);
+        for (int i = 0; i < NNUE_INPUTS; i++) net->w1[i][j] = lrintf(W1[i][j] * A);
+    }
+    for (int k = 0; k < NNUE_HIDDEN2; k++) {
+        net->b2[k] = lrintf(B2[k] * A * W);
+        for (int j = 0; j < NNUE_HIDDEN1; j++) net->w2[k][j] = lrintf(W2[k][j] * W);
+        net->w3[k] = lrintf(W3[k] * W);
+    }
+    net->b3 = lrintf(B3 * A * W);
+}
+
+static bool readSamples(const char *path, vector<Sample> *samples) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return false;
+
+    char squares[65], side[2];
+    int result;
+    while (fscanf(f, "%64s %1s %d", squares, side, &result) == 3) {
+        Sample s;
+        s.black = s.white = 0;
+        for (int i = 0; i < 64; i++) {
+            if (squares[i] == 'b') s.black |= 1ULL << i;
+            if (squares[i] == 'w') s.white |= 1ULL << i;
+        }
+        s.target = result / 64.0f;
+        samples->push_back(s);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 4) {
+        fprintf(stderr, "usage: %s positions weights [epochs]\n", argv[0]);
+        return 1;
+    }
+    int epochs = (argc > 3) ? atoi(argv[3]) : 20;
+
+    vector<Sample> samples;
+    if (!readSamples(argv[1], &samples) || samples.size() < 10) {
+        fprintf(stderr, "could not read enough positions from %s\n", argv[1]);
+        return 1;
+    }
+
+    srand(1);
+    for (int i = (int)samples.size() - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        Sample tmp = samples[i];
+        samples[i] = samples[j];
+        samples[j] = tmp;
+    }
+    // Hold out a tenth of the positions to measure generalization.
+    int numTrain = samples.size() - samples.size() / 10;
+
+    for (int j = 0; j < NNUE_HIDDEN1; j++) {
+        B1[j] = 0.5f;
+        for (int i = 0; i < NNUE_INPUTS; i++) W1[i][j] = uniform(0.1f);
+    }
+    for (int k = 0; k < NNUE_HIDDEN2; k++) {
+        B2[k] = 0;
+        W3[k] = uniform(0.2f);
+        for (int j = 0; j < NNUE_HIDDEN1; j++) W2[k][j] = uniform(0.125f);
+    }
+    B3 = 0;
+
+    float lr = 0.005f;
+    for (int e = 0; e < epochs; e++) {
+        for (int i = numTrain - 1; i > 0; i--) {
+            int j = rand() % (i + 1);
+            Sample tmp = samples[i];
+            samples[i] = samples[j];
+            samples[j] = tmp;
+        }
+
+        double trainLoss = 0, testLoss = 0;
+        for (int i = 0; i < numTrain; i++) trainLoss += step(samples[i], lr);
+        for (int i = numTrain; i < (int)samples.size(); i++) testLoss += step(samples[i], 0);
+
+        // Errors are reported as RMS discs.
+        printf("epoch %d: train %.2f, test %.2f\n", e + 1,
+            64 * sqrt(trainLoss / numTrain),
+            64 * sqrt(testLoss / (samples.size() - numTrain)));
+        fflush(stdout);
+        lr *= 0.9f;
+    }
+
+    Network *net = new Network();
+    quantize(net);
+
+    double quantLoss = 0;
+    for (int i = numTrain; i < (int)samples.size(); i++) {
+        Accumulator acc;
+        net->refresh(&acc, samples[i].black, samples[i].white);
+        double err = net->evaluate(&acc) - 64 * samples[i].target;
+        quantLoss += err * err;
+    }
+    printf("quantized: test %.2f\n", sqrt(quantLoss / (samples.size() - numTrain)));
+
+    if (!net->save(argv[2])) {
+        perror(argv[2]);
+        return 1;
+    }
+    delete net;
+    return 0;
+}
@@ -1,19 +1,32 @@
+#include <thread>
 #include "player.h"
 
+// Thinking time per move for the Monte Carlo engine when msLeft is -1.
+#define MONTE_CARLO_DEFAULT_MS 1000
+
 /*
  * Constructor for the player; initialize everything here. The side your AI is
- * on (BLACK or WHITE) is passed in as "side". The constructor must finish 
+ * on (BLACK or WHITE) is passed in as "side", and "engine" selects between
+ * the alpha-beta and the Monte Carlo search. The constructor must finish 
  * within 30 seconds.
  */
-Player::Player(Side side) {
+Player::Player(Side side, Engine engine) {
     // Will be set to true in test_minimax.cpp.
     testingMinimax = false;
+    searchDepth = 7;
 
     mySide = side;
     other = (side == BLACK) ? WHITE : BLACK;
 
     // create board
     b = new Board();
+
+    this->engine = engine;
+    mc = NULL;
+    net = NULL;
+    if (engine == MONTE_CARLO) {
+        mc = new MonteCarlo(std::thread::hardware_concurrency());
+    }
 }
 
 /*
@@ -21,6 +34,8 @@ Player::Player(Side side) {
  */
 Player::~Player() {
     delete b;
+    delete mc;
+    delete net;
 }
 
 /*
@@ -41,6 +56,9 @@ Move *Player::doMove(Move *opponentsMove, int msLeft) {
      * process the opponent's opponents move before calculating your own move
      */
 
+     // (re)attach the network in case the board was replaced
+     if(net != NULL) b->setNetwork(net);
+
      // process opponents moves
      b->doMove(opponentsMove, other);
 
@@ -53,8 +71,10 @@ Move *Player::doMove(Move *opponentsMove, int msLeft) {
      //Move best = getBestMoveImproved(moves);
      int maxlevel;
      if(testingMinimax) maxlevel = 2;
-     else maxlevel = 7;
-     Move best = getBestMoveNPly(moves, maxlevel);
+     else maxlevel = searchDepth;
+     Move best = (engine == MONTE_CARLO && !testingMinimax)
+         ? getBestMoveMonteCarlo(msLeft)
+         : getBestMoveNPly(moves, maxlevel);
      Move * bestp = new Move(best.getX(), best.getY());
 
      b->doMove(bestp, mySide);
@@ -78,6 +98,7 @@ Move Player::getBestMove(std::vector<Move> moves)
         Board * newb = b->copy();
         newb->doMove(&moves[i], mySide);
         double h = heuristic(newb);
+        delete newb;
         if(h > maxh){
             maxh = h;
             maxIndex = i;
@@ -113,9 +134,11 @@ Move Player::getBestMoveImproved(std::vector<Move> moves)
         if(oppBoards.size() == 0) newb->score = -10000;
         else newb->score = oppBoards[getMinIndex(oppBoards)]->score;
         myboards.push_back(newb);
+        for(int j = 0; j < (int)oppBoards.size(); j++) delete oppBoards[j];
     }
 
     int index = getMaxIndex(myboards);
+    for(int i = 0; i < (int)myboards.size(); i++) delete myboards[i];
     return moves[index];
 }
 
@@ -132,6 +155,7 @@ Move Player::getBestMoveNPly(std::vector<Move> moves, int maxlevel)
         	max = newb->score;
         	maxI = i;
         }
+        delete newb;
     }
 
     //eturn moves[getMaxIndex(boards)];
@@ -165,6 +189,7 @@ void Player::getScore(Board * brd, int maxlevel, int level, bool ourpick, double
             if(newb->score > alpha){
                 alpha = newb->score;
             }
+            delete newb;
             //nextBoards.push_back(newb);
         }
 
@@ -197,6 +222,7 @@ void Player::getScore(Board * brd, int maxlevel, int level, bool ourpick, double
             if(newb->score < beta){
                 beta = newb->score;
             }
+            delete newb;
             //nextBoards.push_back(newb);
         }
 
@@ -216,6 +242,28 @@ void Player::getScore(Board * brd, int maxlevel, int level, bool ourpick, double
 
 }
 
+// runs the Monte Carlo search on the current board within a share of msLeft
+Move Player::getBestMoveMonteCarlo(int msLeft)
+{
+    int budget = MONTE_CARLO_DEFAULT_MS;
+    if(msLeft >= 0){
+        // spread the remaining time over our remaining moves
+        int empties = 64 - b->countBlack() - b->countWhite();
+        budget = msLeft / (empties / 2 + 3);
+        if(budget < 1) budget = 1;
+    }
+
+    uint64_t mine, theirs;
+    b->getBits(mySide, &mine, &theirs);
+    int sq = mc->search(mine, theirs, budget);
+
+    cerr << "mcts: " << mc->playouts << " playouts in " << mc->msUsed
+         << " ms (" << (long long)mc->playoutsPerSecond() << " playouts/sec)"
+         << endl;
+
+    return Move(sq % 8, sq / 8);
+}
+
 // returns the min index of a set of boards
 double Player::getMinIndex(std::vector<Board*> boards)
 {
@@ -263,5 +311,19 @@ double Player::simpleheurisitic(Board * b)
 // returns a score relating to how optimal a board is
 double Player::heuristic(Board * b)
 {
+    if(net != NULL) return b->networkEvaluation(mySide);
     return b->dynamic_heuristic_evaluation_function(mySide);
+}
+
+// loads network weights and uses them in place of the hand-tuned heuristic
+bool Player::loadNetwork(const char *path)
+{
+    Network * n = new Network();
+    if(!n->load(path)){
+        delete n;
+        return false;
+    }
+    delete net;
+    net = n;
+    return true;
 }
\ No newline at end of file
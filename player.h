@@ -4,6 +4,8 @@
 #include <iostream>
 #include "common.h"
 #include "board.h"
+#include "montecarlo.h"
+#include "nnue.h"
 using namespace std;
 
 class Player {
@@ -11,10 +13,13 @@ class Player {
 private:
     Side  mySide;
     Side other;
+    Engine engine;
+    MonteCarlo *mc;
+    Network *net;
     
 public:
     Board *b;
-    Player(Side side);
+    Player(Side side, Engine engine = ALPHA_BETA);
     ~Player();
     
     Move *doMove(Move *opponentsMove, int msLeft);
@@ -27,9 +32,14 @@ public:
     double simpleheurisitic(Board * b);
     Move getBestMoveNPly(std::vector<Move> moves, int maxlevel);
     void getScore(Board * brd, int maxlevel, int level, bool ourpick, double alpha, double beta);
+    Move getBestMoveMonteCarlo(int msLeft);
+    bool loadNetwork(const char *path);
     
     // Flag to tell if the player is running within the test_minimax context
     bool testingMinimax;
+
+    // Alpha-beta search depth outside of the test_minimax context
+    int searchDepth;
 };
 
 #endif
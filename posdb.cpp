@@ -0,0 +1,718 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bitboard.h"
+#include "search.h"
+using namespace std;
+
+/*
+ * Position database over game archives. Games are replayed on bitboards,
+ * in parallel, and every position reached is keyed by the hash of its
+ * canonical (symmetry-reduced) form. For each position the index keeps
+ * win/draw/loss counts for the side to move, split by the next move played
+ * (in the canonical frame, one square for all moves the position's own
+ * symmetries make equivalent; END for the final position of a game).
+ *
+ * Games are read one per line as a string of moves from the starting
+ * position, e.g. "f5d6c3d3c4...", where a-h is x and 1-8 is y + 1; passes
+ * are implied. Anything after the first blank is ignored, as are blank
+ * lines and lines starting with '#'. Games that stop early are scored by
+ * their last position, as finished games are.
+ *
+ * The index file is sorted by key and cut into blocks of BLOCK_POSITIONS
+ * positions, each varint-coded with delta-coded keys. A table of the first
+ * key and offset of every block follows the blocks. Queries mmap the file,
+ * binary search the table and decode a single block. Adding games writes
+ * sorted runs of the new positions and merges them with the existing index
+ * into a new file.
+ *
+ * usage: posdb add index games...
+ *        posdb query index [moves]
+ *        posdb stats index
+ */
+
+#define BLOCK_POSITIONS 64
+#define END_MOVE 255
+
+// Games replayed per batch. Adding games needs memory for one batch of rows,
+// whatever the size of the index.
+#define BATCH_GAMES 100000
+
+static const char MAGIC[4] = { 'S', 'K', 'P', 'D' };
+static const uint32_t VERSION = 2;
+
+// One row per (position, next move).
+struct Row {
+    uint64_t key;
+    uint32_t count;
+    uint32_t wins;
+    uint32_t draws;
+    uint8_t move;
+};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t positions;
+    uint64_t rows;
+    uint64_t blocks;
+    uint64_t tableOffset;
+};
+
+struct BlockStart {
+    uint64_t firstKey;
+    uint64_t offset;
+};
+
+static bool rowLess(const Row &a, const Row &b) {
+    return (a.key != b.key) ? a.key < b.key : a.move < b.move;
+}
+
+/*
+ * Sums rows with the same key and move. Rows must be sorted.
+ */
+static void reduce(vector<Row> *rows) {
+    size_t out = 0;
+    for (size_t i = 0; i < rows->size(); i++) {
+        Row &r = (*rows)[i];
+        if (out > 0 && (*rows)[out - 1].key == r.key && (*rows)[out - 1].move == r.move) {
+            (*rows)[out - 1].count += r.count;
+            (*rows)[out - 1].wins += r.wins;
+            (*rows)[out - 1].draws += r.draws;
+        } else {
+            (*rows)[out++] = r;
+        }
+    }
+    rows->resize(out);
+}
+
+/*
+ * The square standing for a move of a canonical position. Moves that the
+ * position's own symmetries map onto each other lead to the same position,
+ * so they all stand for the smallest of them.
+ */
+static int canonicalMove(uint64_t mine, uint64_t theirs, int move) {
+    int best = move;
+    for (int sym = 1; sym < 8; sym++) {
+        if (bbTransform(mine, sym) != mine || bbTransform(theirs, sym) != theirs) continue;
+        best = min(best, bbTransformSquare(move, sym));
+    }
+    return best;
+}
+
+static Row makeRow(uint64_t mine, uint64_t theirs, int move, int result) {
+    int sym = bbCanonical(&mine, &theirs);
+    Row r;
+    r.key = bbHash(mine, theirs);
+    r.move = (move == END_MOVE) ? END_MOVE
+        : canonicalMove(mine, theirs, bbTransformSquare(move, sym));
+    r.count = 1;
+    r.wins = (result > 0);
+    r.draws = (result == 0);
+    return r;
+}
+
+/*
+ * Replays one game, appending a row for every position it reached.
+ * Returns false, adding nothing, if the game has an illegal move.
+ */
+static bool replay(const string &line, vector<Row> *rows) {
+    uint64_t mine = 0x0000000810000000ULL;
+    uint64_t theirs = 0x0000001008000000ULL;
+    bool blackToMove = true;
+    vector<int> moves;
+
+    for (size_t i = 0; i + 1 < line.size() && !isspace(line[i]); i += 2) {
+        int x = tolower(line[i]) - 'a';
+        int y = line[i + 1] - '1';
+        if (x < 0 || x > 7 || y < 0 || y > 7) return false;
+        moves.push_back(x + 8 * y);
+    }
+
+    // First find the result, then record each position with it.
+    vector<uint64_t> boards;
+    for (int i = 0; i < (int)moves.size(); i++) {
+        if (bbMoves(mine, theirs) == 0) {
+            bbDoMove(&mine, &theirs, PASS_MOVE);
+            blackToMove = !blackToMove;
+        }
+        if (!(bbMoves(mine, theirs) >> moves[i] & 1)) return false;
+        boards.push_back(mine);
+        boards.push_back(theirs);
+        boards.push_back(blackToMove);
+        bbDoMove(&mine, &theirs, moves[i]);
+        blackToMove = !blackToMove;
+    }
+    int blackResult = finalScore(mine, theirs) * (blackToMove ? 1 : -1);
+
+    for (int i = 0; i < (int)moves.size(); i++) {
+        int result = boards[3 * i + 2] ? blackResult : -blackResult;
+        rows->push_back(makeRow(boards[3 * i], boards[3 * i + 1], moves[i], result));
+    }
+    rows->push_back(makeRow(mine, theirs, END_MOVE, blackToMove ? blackResult : -blackResult));
+    return true;
+}
+
+/*
+ * Replays a batch of games on all cores, one sorted, reduced run of rows
+ * per thread. Adds the number of unreadable games to *bad.
+ */
+static vector<vector<Row> > replayAll(const vector<string> &games, int *bad) {
+    int numThreads = thread::hardware_concurrency();
+    if (numThreads < 1) numThreads = 1;
+
+    vector<vector<Row> > runs(numThreads);
+    vector<int> failures(numThreads, 0);
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.push_back(thread([&, t]() {
+            for (size_t g = t; g < games.size(); g += numThreads) {
+                if (!replay(games[g], &runs[t])) failures[t]++;
+            }
+            sort(runs[t].begin(), runs[t].end(), rowLess);
+            reduce(&runs[t]);
+        }));
+    }
+    for (int t = 0; t < numThreads; t++) {
+        threads[t].join();
+        *bad += failures[t];
+    }
+    return runs;
+}
+
+static void putVarint(string *out, uint64_t v) {
+    while (v >= 0x80) {
+        out->push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out->push_back((char)v);
+}
+
+/*
+ * A read-only, memory-mapped index.
+ */
+struct Index {
+    const uint8_t *data;
+    size_t size;
+    const Header *header;
+    const BlockStart *table;
+};
+
+/*
+ * Checks the header and block table of a mapped index, so that a corrupt
+ * file cannot send readers to a block outside it. The table must be
+ * aligned for its 64-bit fields, and the blocks must lie in order before
+ * it. Blocks themselves are checked as they are decoded.
+ */
+static bool validIndex(const Index &index) {
+    const Header *h = index.header;
+    if (memcmp(h->magic, MAGIC, 4) != 0 || h->version != VERSION) return false;
+    if (h->tableOffset % 8 != 0 || h->tableOffset > index.size
+        || h->blocks > (index.size - h->tableOffset) / sizeof(BlockStart)) {
+        return false;
+    }
+    uint64_t prev = sizeof(Header);
+    for (uint64_t b = 0; b < h->blocks; b++) {
+        if (index.table[b].offset < prev || index.table[b].offset >= h->tableOffset) return false;
+        if (b > 0 && index.table[b].firstKey <= index.table[b - 1].firstKey) return false;
+        prev = index.table[b].offset + 1;
+    }
+    return true;
+}
+
+static bool openIndex(const char *path, Index *index) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+
+    index->data = (const uint8_t *)p;
+    index->size = st.st_size;
+    index->header = (const Header *)p;
+    index->table = (const BlockStart *)(index->data + index->header->tableOffset);
+    if (!validIndex(*index)) {
+        munmap(p, st.st_size);
+        return false;
+    }
+    return true;
+}
+
+static void closeIndex(Index *index) {
+    munmap((void *)index->data, index->size);
+}
+
+/*
+ * Decodes the rows of one block. Reads stop at the block's end, which is
+ * the next block's offset or the table, and anything that does not decode
+ * within it marks the block bad.
+ */
+struct BlockReader {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint64_t key;
+    uint64_t positionsLeft;
+    uint64_t rowsLeft;
+    bool bad;
+};
+
+static uint64_t readVarint(BlockReader *r) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && r->p < r->end; shift += 7) {
+        uint8_t b = *r->p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    r->bad = true;
+    return 0;
+}
+
+static void startBlock(const Index &index, uint64_t b, BlockReader *r) {
+    r->p = index.data + index.table[b].offset;
+    r->end = index.data + ((b + 1 < index.header->blocks)
+        ? index.table[b + 1].offset : index.header->tableOffset);
+    r->key = index.table[b].firstKey;
+    r->rowsLeft = 0;
+    r->bad = false;
+    r->positionsLeft = readVarint(r);
+    if (r->positionsLeft == 0 || r->positionsLeft > BLOCK_POSITIONS) r->bad = true;
+}
+
+/*
+ * Reads the block's next row. Returns false at the end of the block, or
+ * if it turns out to be bad.
+ */
+static bool nextRow(BlockReader *r, Row *row) {
+    if (r->bad) return false;
+    if (r->rowsLeft == 0) {
+        if (r->positionsLeft == 0) return false;
+        r->key += readVarint(r);
+        r->rowsLeft = readVarint(r);
+        r->positionsLeft--;
+        if (r->rowsLeft == 0 || r->rowsLeft > END_MOVE + 1) r->bad = true;
+    }
+    if (r->p == r->end) r->bad = true;
+    if (r->bad) return false;
+
+    row->key = r->key;
+    row->move = *r->p++;
+    uint64_t count = readVarint(r);
+    uint64_t wins = readVarint(r);
+    uint64_t draws = readVarint(r);
+    if (count > UINT32_MAX || wins + draws > count) r->bad = true;
+    row->count = count;
+    row->wins = wins;
+    row->draws = draws;
+    r->rowsLeft--;
+    return !r->bad;
+}
+
+/*
+ * Reads the rows of an index in order, one block at a time.
+ */
+struct Cursor {
+    Index index;
+    uint64_t block;
+    BlockReader reader;
+    Row row;
+};
+
+/*
+ * Moves the cursor to its next row. Returns false at the end of the index
+ * or at a bad block, which leaves reader.bad set.
+ */
+static bool advance(Cursor *c) {
+    while (!nextRow(&c->reader, &c->row)) {
+        if (c->reader.bad || c->block == c->index.header->blocks) return false;
+        startBlock(c->index, c->block++, &c->reader);
+    }
+    return true;
+}
+
+/*
+ * Writes an index from rows given in order, summing repeated rows. Blocks
+ * go to the file as they fill up and the block table to a second file,
+ * which is copied behind the blocks at the end, so memory use does not
+ * depend on the size of the index.
+ */
+struct Writer {
+    string path;
+    FILE *f;
+    FILE *table;
+    Header header;
+    uint64_t offset;
+
+    vector<Row> position;
+    string block;
+    int blockPositions;
+    uint64_t blockFirst;
+    uint64_t prevKey;
+};
+
+static bool openWriter(Writer *w, const string &path) {
+    w->path = path;
+    w->f = fopen(path.c_str(), "wb");
+    w->table = tmpfile();
+    if (w->f == NULL || w->table == NULL) {
+        if (w->f != NULL) fclose(w->f);
+        if (w->table != NULL) fclose(w->table);
+        return false;
+    }
+    memset(&w->header, 0, sizeof(w->header));
+    memcpy(w->header.magic, MAGIC, 4);
+    w->header.version = VERSION;
+    fwrite(&w->header, sizeof(w->header), 1, w->f);
+    w->offset = sizeof(w->header);
+    w->position.clear();
+    w->block.clear();
+    w->blockPositions = 0;
+    return true;
+}
+
+static void flushBlock(Writer *w) {
+    if (w->blockPositions == 0) return;
+    string count;
+    putVarint(&count, w->blockPositions);
+    fwrite(count.data(), 1, count.size(), w->f);
+    fwrite(w->block.data(), 1, w->block.size(), w->f);
+
+    BlockStart start;
+    start.firstKey = w->blockFirst;
+    start.offset = w->offset;
+    fwrite(&start, sizeof(start), 1, w->table);
+
+    w->offset += count.size() + w->block.size();
+    w->header.blocks++;
+    w->block.clear();
+    w->blockPositions = 0;
+}
+
+static void flushPosition(Writer *w) {
+    if (w->position.empty()) return;
+    uint64_t key = w->position[0].key;
+    if (w->blockPositions == 0) {
+        w->blockFirst = key;
+        w->prevKey = key;
+    }
+    putVarint(&w->block, key - w->prevKey);
+    putVarint(&w->block, w->position.size());
+    for (size_t i = 0; i < w->position.size(); i++) {
+        w->block.push_back((char)w->position[i].move);
+        putVarint(&w->block, w->position[i].count);
+        putVarint(&w->block, w->position[i].wins);
+        putVarint(&w->block, w->position[i].draws);
+    }
+    w->prevKey = key;
+    w->header.positions++;
+    w->header.rows += w->position.size();
+    w->position.clear();
+    if (++w->blockPositions == BLOCK_POSITIONS) flushBlock(w);
+}
+
+static void writeRow(Writer *w, const Row &r) {
+    if (!w->position.empty()) {
+        Row &last = w->position.back();
+        if (last.key == r.key && last.move == r.move) {
+            last.count += r.count;
+            last.wins += r.wins;
+            last.draws += r.draws;
+            return;
+        }
+        if (last.key != r.key) flushPosition(w);
+    }
+    w->position.push_back(r);
+}
+
+/*
+ * Finishes the index. Pads the blocks so that the table, and hence the
+ * 64-bit fields read from the mapped file, are aligned.
+ */
+static bool closeWriter(Writer *w) {
+    flushPosition(w);
+    flushBlock(w);
+    while (w->offset % 8 != 0) {
+        fputc(0, w->f);
+        w->offset++;
+    }
+    w->header.tableOffset = w->offset;
+
+    char buf[1 << 16];
+    size_t n;
+    rewind(w->table);
+    while ((n = fread(buf, 1, sizeof(buf), w->table)) > 0) fwrite(buf, 1, n, w->f);
+    bool ok = !ferror(w->table);
+    fclose(w->table);
+
+    fseek(w->f, 0, SEEK_SET);
+    fwrite(&w->header, sizeof(w->header), 1, w->f);
+    ok = ok && !ferror(w->f);
+    return (fclose(w->f) == 0) && ok;
+}
+
+/*
+ * Writes one sorted, reduced run of rows as an index file.
+ */
+static bool writeRun(const string &path, const vector<Row> &rows) {
+    Writer w;
+    if (!openWriter(&w, path)) return false;
+    for (size_t i = 0; i < rows.size(); i++) writeRow(&w, rows[i]);
+    return closeWriter(&w);
+}
+
+struct CursorAfter {
+    bool operator()(const Cursor *a, const Cursor *b) const {
+        return rowLess(b->row, a->row);
+    }
+};
+
+/*
+ * Merges indexes into a new index file, streaming their rows in key order.
+ */
+static bool mergeIndexes(const vector<Index> &inputs, const string &path) {
+    Writer w;
+    if (!openWriter(&w, path)) {
+        perror(path.c_str());
+        return false;
+    }
+
+    vector<Cursor> cursors(inputs.size());
+    priority_queue<Cursor *, vector<Cursor *>, CursorAfter> queue;
+    bool bad = false;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        cursors[i].index = inputs[i];
+        cursors[i].block = 0;
+        cursors[i].reader.positionsLeft = 0;
+        cursors[i].reader.rowsLeft = 0;
+        cursors[i].reader.bad = false;
+        if (advance(&cursors[i])) queue.push(&cursors[i]);
+        bad = bad || cursors[i].reader.bad;
+    }
+    while (!queue.empty() && !bad) {
+        Cursor *c = queue.top();
+        queue.pop();
+        writeRow(&w, c->row);
+        if (advance(c)) queue.push(c);
+        bad = c->reader.bad;
+    }
+
+    if (!closeWriter(&w)) {
+        perror(path.c_str());
+        return false;
+    }
+    if (bad) fprintf(stderr, "corrupt block in an index being merged\n");
+    return !bad;
+}
+
+/*
+ * Replays the given game files and merges their positions into the index,
+ * creating it if needed. Each batch of games is sorted into runs on disk,
+ * and the runs are then merged with the existing index into a new file
+ * that replaces it atomically.
+ */
+static int add(const char *path, char **files, int numFiles) {
+    vector<Index> inputs;
+    Index index;
+    if (openIndex(path, &index)) {
+        inputs.push_back(index);
+    } else if (access(path, F_OK) == 0) {
+        fprintf(stderr, "%s is not a position index\n", path);
+        return 1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<string> runPaths;
+    long total = 0;
+    int bad = 0;
+    bool ok = true;
+    for (int i = 0; i < numFiles && ok; i++) {
+        FILE *f = fopen(files[i], "r");
+        if (f == NULL) {
+            perror(files[i]);
+            ok = false;
+            break;
+        }
+        vector<string> games;
+        char line[1024];
+        bool more = true;
+        while (more && ok) {
+            more = fgets(line, sizeof(line), f) != NULL;
+            if (more && line[0] != '#' && !isspace(line[0])) games.push_back(line);
+            if (games.size() < BATCH_GAMES && (more || games.empty())) continue;
+
+            vector<vector<Row> > runs = replayAll(games, &bad);
+            for (size_t r = 0; r < runs.size() && ok; r++) {
+                if (runs[r].empty()) continue;
+                string run = string(path) + ".run" + to_string(runPaths.size());
+                runPaths.push_back(run);
+                ok = writeRun(run, runs[r]) && openIndex(run.c_str(), &index);
+                if (ok) inputs.push_back(index);
+                else perror(run.c_str());
+            }
+            total += games.size();
+            games.clear();
+            fprintf(stderr, "%ld games, %d unreadable\n", total, bad);
+        }
+        fclose(f);
+    }
+
+    if (ok) {
+        double sec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "replayed %ld games in %.1f s, merging %d runs\n", total, sec,
+            (int)runPaths.size());
+        string tmp = string(path) + ".tmp";
+        ok = mergeIndexes(inputs, tmp);
+        if (ok && rename(tmp.c_str(), path) != 0) {
+            perror(path);
+            ok = false;
+        }
+        if (!ok) unlink(tmp.c_str());
+    }
+
+    for (size_t i = 0; i < inputs.size(); i++) closeIndex(&inputs[i]);
+    for (size_t i = 0; i < runPaths.size(); i++) unlink(runPaths[i].c_str());
+    return ok ? 0 : 1;
+}
+
+/*
+ * Finds the rows of one canonical position. Returns false if the index
+ * has never seen it, or if its block is bad, which sets *bad.
+ */
+static bool lookup(const Index &index, uint64_t key, vector<Row> *rows, bool *bad) {
+    const BlockStart *table = index.table;
+    uint64_t n = index.header->blocks;
+
+    // Last block whose first key is not above the key.
+    uint64_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) / 2;
+        if (table[mid].firstKey <= key) lo = mid + 1;
+        else hi = mid;
+    }
+    rows->clear();
+    *bad = false;
+    if (lo == 0) return false;
+
+    // Walk the block's rows up to the key.
+    BlockReader reader;
+    Row r;
+    startBlock(index, lo - 1, &reader);
+    while (nextRow(&reader, &r) && r.key <= key) {
+        if (r.key == key) rows->push_back(r);
+    }
+    *bad = reader.bad;
+    return !reader.bad && !rows->empty();
+}
+
+static string squareName(int sq) {
+    string name = "a1";
+    name[0] += sq % 8;
+    name[1] += sq / 8;
+    return name;
+}
+
+/*
+ * Prints the statistics of the position reached by a move string.
+ */
+static int query(const char *path, const char *moves) {
+    Index index;
+    if (!openIndex(path, &index)) {
+        fprintf(stderr, "cannot open index %s\n", path);
+        return 1;
+    }
+
+    uint64_t mine = 0x0000000810000000ULL;
+    uint64_t theirs = 0x0000001008000000ULL;
+    for (size_t i = 0; i + 1 < strlen(moves); i += 2) {
+        if (bbMoves(mine, theirs) == 0) bbDoMove(&mine, &theirs, PASS_MOVE);
+        int sq = (tolower(moves[i]) - 'a') + 8 * (moves[i + 1] - '1');
+        if (sq < 0 || sq > 63 || !(bbMoves(mine, theirs) >> sq & 1)) {
+            fprintf(stderr, "illegal move %.2s\n", moves + i);
+            return 1;
+        }
+        bbDoMove(&mine, &theirs, sq);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int sym = bbCanonical(&mine, &theirs);
+    uint64_t key = bbHash(mine, theirs);
+    vector<Row> rows;
+    bool bad;
+    bool found = lookup(index, key, &rows, &bad);
+    double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+    if (bad) {
+        fprintf(stderr, "corrupt block in index %s\n", path);
+        closeIndex(&index);
+        return 1;
+    }
+    printf("key %016llx, lookup %.1f us\n", (unsigned long long)key, us);
+    if (!found) {
+        printf("not in index\n");
+        closeIndex(&index);
+        return 0;
+    }
+
+    uint32_t count = 0, wins = 0, draws = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        count += rows[i].count;
+        wins += rows[i].wins;
+        draws += rows[i].draws;
+    }
+    printf("%u games: %u wins, %u draws, %u losses for the side to move\n",
+        count, wins, draws, count - wins - draws);
+
+    // Show the most played moves first, in the orientation of the query.
+    sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.count > b.count; });
+    for (size_t i = 0; i < rows.size(); i++) {
+        string name = (rows[i].move == END_MOVE) ? "end"
+            : squareName(bbTransformSquare(rows[i].move, bbInverse(sym)));
+        printf("  %-4s %8u games %8u wins %8u draws %8u losses\n", name.c_str(),
+            rows[i].count, rows[i].wins, rows[i].draws,
+            rows[i].count - rows[i].wins - rows[i].draws);
+    }
+    closeIndex(&index);
+    return 0;
+}
+
+static int stats(const char *path) {
+    Index index;
+    if (!openIndex(path, &index)) {
+        fprintf(stderr, "cannot open index %s\n", path);
+        return 1;
+    }
+    printf("%llu positions, %llu rows, %llu blocks, %llu bytes (%.1f bytes/position)\n",
+        (unsigned long long)index.header->positions, (unsigned long long)index.header->rows,
+        (unsigned long long)index.header->blocks, (unsigned long long)index.size,
+        index.header->positions ? (double)index.size / index.header->positions : 0.0);
+    closeIndex(&index);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 4 && !strcmp(argv[1], "add")) return add(argv[2], argv + 3, argc - 3);
+    if ((argc == 3 || argc == 4) && !strcmp(argv[1], "query")) {
+        return query(argv[2], (argc == 4) ? argv[3] : "");
+    }
+    if (argc == 3 && !strcmp(argv[1], "stats")) return stats(argv[2]);
+
+    fprintf(stderr, "usage: %s add index games...\n"
+        "       %s query index [moves]\n"
+        "       %s stats index\n", argv[0], argv[0], argv[0]);
+    return 1;
+}
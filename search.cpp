@@ -0,0 +1,286 @@
+#include "search.h"
+
+using namespace std;
+
+// Nodes between two looks at the clock.
+#define CHECK_INTERVAL 4096
+
+// Above this many empty squares the solver orders moves fastest-first.
+#define SOLVE_ORDER_EMPTIES 7
+
+/*
+ * Creates a searcher with no node or time limit.
+ */
+Search::Search() {
+    maxNodes = 0;
+    msLimit = 0;
+    limited = false;
+    nodes = 0;
+    depthReached = 0;
+    aborted = false;
+    msToBest = 0;
+    nodesToBest = 0;
+}
+
+/*
+ * Destructor for the searcher.
+ */
+Search::~Search() {
+}
+
+/*
+ * Limits later searches to maxNodes nodes and msLimit milliseconds; zero
+ * means no limit. search() always finishes its first iteration.
+ */
+void Search::setLimits(long long maxNodes, int msLimit) {
+    this->maxNodes = maxNodes;
+    this->msLimit = msLimit;
+}
+
+/*
+ * Disc differential of a finished game, empty squares going to the winner.
+ */
+int finalScore(uint64_t mine, uint64_t theirs) {
+    int m = bbCount(mine);
+    int t = bbCount(theirs);
+    int e = 64 - m - t;
+    if (m > t) return m - t + e;
+    if (m < t) return m - t - e;
+    return 0;
+}
+
+static double finalValue(uint64_t mine, uint64_t theirs) {
+    int s = finalScore(mine, theirs);
+    if (s > 0) return SEARCH_WIN + s;
+    if (s < 0) return -SEARCH_WIN + s;
+    return 0;
+}
+
+/*
+ * Lists the moves in "moves", optionally sorted so that replies leaving
+ * the opponent the fewest moves come first. Returns the number of moves.
+ */
+static int listMoves(uint64_t mine, uint64_t theirs, uint64_t moves, int *list,
+                     bool sort) {
+    int keys[64];
+    int n = 0;
+
+    for (; moves; moves &= moves - 1) {
+        int sq = bbFirst(moves);
+        int key = 0;
+        if (sort) {
+            uint64_t m = mine;
+            uint64_t t = theirs;
+            bbDoMove(&m, &t, sq);
+            key = bbCount(bbMoves(m, t));
+        }
+
+        // insertion sort; stable, so unsorted lists keep square order
+        int i = n++;
+        for (; i > 0 && keys[i - 1] > key; i--) {
+            keys[i] = keys[i - 1];
+            list[i] = list[i - 1];
+        }
+        keys[i] = key;
+        list[i] = sq;
+    }
+    return n;
+}
+
+bool Search::outOfBudget() {
+    if (aborted || !limited) return aborted;
+
+    if (maxNodes > 0 && nodes >= maxNodes) aborted = true;
+    if (msLimit > 0 && nodes % CHECK_INTERVAL == 0
+        && chrono::steady_clock::now() >= deadline) aborted = true;
+    return aborted;
+}
+
+double Search::negamax(uint64_t mine, uint64_t theirs, int depth,
+                       double alpha, double beta, bool passed) {
+    nodes++;
+    if (outOfBudget()) return 0;
+    if (depth == 0) {
+        if (bbMoves(mine, theirs) == 0 && bbMoves(theirs, mine) == 0) {
+            return finalValue(mine, theirs);
+        }
+        return bbEvaluate(mine, theirs);
+    }
+
+    uint64_t moves = bbMoves(mine, theirs);
+    if (moves == 0) {
+        if (passed) return finalValue(mine, theirs);
+        return -negamax(theirs, mine, depth, -beta, -alpha, true);
+    }
+
+    int list[64];
+    int n = listMoves(mine, theirs, moves, list, depth >= 3);
+    double best = -2 * SEARCH_WIN;
+    for (int i = 0; i < n; i++) {
+        uint64_t m = mine;
+        uint64_t t = theirs;
+        bbDoMove(&m, &t, list[i]);
+        double v = -negamax(m, t, depth - 1, -beta, -alpha, false);
+        if (aborted) return 0;
+
+        if (v > best) {
+            best = v;
+            if (v > alpha) alpha = v;
+            if (alpha >= beta) break;
+        }
+    }
+    return best;
+}
+
+/*
+ * Searches to maxDepth plies by iterative deepening, stopping early at the
+ * limits set by setLimits(). Stores the score of the deepest completed
+ * iteration, for the side to move, in *score and returns its best move,
+ * or PASS_MOVE if the side to move has to pass.
+ */
+int Search::search(uint64_t mine, uint64_t theirs, int maxDepth, double *score) {
+    nodes = 0;
+    depthReached = 0;
+    aborted = false;
+    limited = false;
+    deadline = chrono::steady_clock::now() + chrono::milliseconds(msLimit);
+
+    uint64_t moves = bbMoves(mine, theirs);
+    if (moves == 0) {
+        if (bbMoves(theirs, mine) == 0) {
+            *score = finalValue(mine, theirs);
+            depthReached = maxDepth;
+        } else {
+            // Deepen on the position after the pass, so the limits apply.
+            search(theirs, mine, maxDepth, score);
+            *score = -*score;
+        }
+        return PASS_MOVE;
+    }
+
+    int list[64];
+    int n = listMoves(mine, theirs, moves, list, true);
+    int empties = 64 - bbCount(mine | theirs);
+    int best = list[0];
+    *score = 0;
+
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        double alpha = -2 * SEARCH_WIN;
+        int iterBest = list[0];
+        for (int i = 0; i < n; i++) {
+            uint64_t m = mine;
+            uint64_t t = theirs;
+            bbDoMove(&m, &t, list[i]);
+            double v = -negamax(m, t, depth - 1, -2 * SEARCH_WIN, -alpha, false);
+            if (aborted) break;
+            if (v > alpha) {
+                alpha = v;
+                iterBest = list[i];
+            }
+        }
+        if (aborted) break;
+
+        best = iterBest;
+        *score = alpha;
+        depthReached = depth;
+
+        // Try the best move first in the next iteration.
+        int k = 0;
+        while (list[k] != best) k++;
+        for (; k > 0; k--) list[k] = list[k - 1];
+        list[0] = best;
+
+        // Limits only apply once there is a complete iteration to fall back on.
+        limited = true;
+
+        // Stop once the game's end is within reach or decided.
+        if (depth >= empties || alpha >= SEARCH_WIN || alpha <= -SEARCH_WIN) break;
+    }
+    return best;
+}
+
+int Search::solveNegamax(uint64_t mine, uint64_t theirs, int alpha, int beta,
+                         bool passed) {
+    nodes++;
+    if (outOfBudget()) return 0;
+
+    uint64_t empty = ~(mine | theirs);
+    if (bbCount(empty) == 1) {
+        // Last square: whoever can flip plays it.
+        int sq = bbFirst(empty);
+        uint64_t flips = bbFlips(mine, theirs, sq);
+        if (flips) return finalScore(mine | flips | (1ULL << sq), theirs & ~flips);
+        flips = bbFlips(theirs, mine, sq);
+        if (flips) return -finalScore(theirs | flips | (1ULL << sq), mine & ~flips);
+        return finalScore(mine, theirs);
+    }
+
+    uint64_t moves = bbMoves(mine, theirs);
+    if (moves == 0) {
+        if (passed) return finalScore(mine, theirs);
+        return -solveNegamax(theirs, mine, -beta, -alpha, true);
+    }
+
+    int list[64];
+    int n = listMoves(mine, theirs, moves, list, bbCount(empty) > SOLVE_ORDER_EMPTIES);
+    int best = -65;
+    for (int i = 0; i < n; i++) {
+        uint64_t m = mine;
+        uint64_t t = theirs;
+        bbDoMove(&m, &t, list[i]);
+        int v = -solveNegamax(m, t, -beta, -alpha, false);
+        if (aborted) return 0;
+
+        if (v > best) {
+            best = v;
+            if (v > alpha) alpha = v;
+            if (alpha >= beta) break;
+        }
+    }
+    return best;
+}
+
+/*
+ * Solves the position exactly. Stores the final disc differential under
+ * perfect play, for the side to move, in *score and returns a best move,
+ * or PASS_MOVE if the side to move has to pass.
+ */
+int Search::solve(uint64_t mine, uint64_t theirs, int *score) {
+    nodes = 0;
+    depthReached = 0;
+    aborted = false;
+    limited = true;
+    msToBest = 0;
+    nodesToBest = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    deadline = start + chrono::milliseconds(msLimit);
+
+    uint64_t moves = bbMoves(mine, theirs);
+    if (moves == 0) {
+        *score = solveNegamax(mine, theirs, -64, 64, false);
+        return PASS_MOVE;
+    }
+
+    int list[64];
+    int n = listMoves(mine, theirs, moves, list, true);
+    int best = list[0];
+    int alpha = -65;
+    for (int i = 0; i < n; i++) {
+        uint64_t m = mine;
+        uint64_t t = theirs;
+        bbDoMove(&m, &t, list[i]);
+        int v = -solveNegamax(m, t, -64, -alpha, false);
+        if (aborted) break;
+        if (v > alpha) {
+            alpha = v;
+            best = list[i];
+            nodesToBest = nodes;
+            msToBest = chrono::duration<double, milli>(
+                chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    *score = alpha;
+    depthReached = 64 - bbCount(mine | theirs);
+    return best;
+}
@@ -0,0 +1,50 @@
+#ifndef __SEARCH_H__
+#define __SEARCH_H__
+
+#include <chrono>
+#include <stdint.h>
+#include "bitboard.h"
+
+// Finished games score SEARCH_WIN plus the final disc differential for the
+// winner, minus that for the loser, so any win beats any heuristic score.
+#define SEARCH_WIN 1.e7
+
+/*
+ * Iterative deepening alpha-beta on bitboards with bbEvaluate() at the
+ * leaves, plus an exact endgame solver. Not thread safe; give every
+ * thread its own Search.
+ */
+class Search {
+
+private:
+    long long maxNodes;
+    int msLimit;
+    bool limited;
+    std::chrono::steady_clock::time_point deadline;
+
+    bool outOfBudget();
+    double negamax(uint64_t mine, uint64_t theirs, int depth,
+                   double alpha, double beta, bool passed);
+    int solveNegamax(uint64_t mine, uint64_t theirs, int alpha, int beta,
+                     bool passed);
+
+public:
+    Search();
+    ~Search();
+
+    void setLimits(long long maxNodes, int msLimit);
+    int search(uint64_t mine, uint64_t theirs, int maxDepth, double *score);
+    int solve(uint64_t mine, uint64_t theirs, int *score);
+
+    // Statistics of the last call to search() or solve().
+    long long nodes;
+    int depthReached;
+    bool aborted;
+    // solve() only: when the root settled on the move it returned.
+    double msToBest;
+    long long nodesToBest;
+};
+
+int finalScore(uint64_t mine, uint64_t theirs);
+
+#endif
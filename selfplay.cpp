@@ -0,0 +1,89 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "player.h"
+#include "bitboard.h"
+using namespace std;
+
+/*
+ * Plays the engine against itself and writes every position reached, one
+ * per line, for training the network with nnuetrain:
+ *
+ *     <64 squares, 'b', 'w' or '-'> <side to move, 'b' or 'w'> <result>
+ *
+ * where result is the final black minus white disc count of the game.
+ * The first few plies of each game are random so the games differ.
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 5) {
+        fprintf(stderr, "usage: %s games output [depth] [randomplies]\n", argv[0]);
+        return 1;
+    }
+    int games = atoi(argv[1]);
+    int depth = (argc > 3) ? atoi(argv[3]) : 3;
+    int randomPlies = (argc > 4) ? atoi(argv[4]) : 8;
+
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+    srand(time(NULL));
+
+    Player *black = new Player(BLACK);
+    Player *white = new Player(WHITE);
+    black->searchDepth = depth;
+    white->searchDepth = depth;
+
+    long positions = 0;
+    for (int g = 0; g < games; g++) {
+        Board board;
+        Side side = BLACK;
+        vector<string> seen;
+
+        for (int ply = 0; !board.isDone(); ply++) {
+            uint64_t mine, theirs;
+            board.getBits(side, &mine, &theirs);
+            uint64_t moves = bbMoves(mine, theirs);
+
+            if (moves != 0) {
+                Move *move;
+                if (ply < randomPlies) {
+                    int k = rand() % bbCount(moves);
+                    while (k--) moves &= moves - 1;
+                    move = new Move(bbFirst(moves) % 8, bbFirst(moves) / 8);
+                } else {
+                    string line(64, '-');
+                    for (int i = 0; i < 64; i++) {
+                        if (mine >> i & 1) line[i] = (side == BLACK) ? 'b' : 'w';
+                        if (theirs >> i & 1) line[i] = (side == BLACK) ? 'w' : 'b';
+                    }
+                    line += (side == BLACK) ? " b" : " w";
+                    seen.push_back(line);
+
+                    // Bring the player's board up to date, then let it move.
+                    Player *player = (side == BLACK) ? black : white;
+                    player->b->setBits(side, mine, theirs);
+                    move = player->doMove(NULL, -1);
+                }
+                board.doMove(move, side);
+                delete move;
+            }
+            side = (side == BLACK) ? WHITE : BLACK;
+        }
+
+        int result = board.countBlack() - board.countWhite();
+        for (int i = 0; i < (int)seen.size(); i++) {
+            fprintf(out, "%s %d\n", seen[i].c_str(), result);
+        }
+        positions += seen.size();
+        fprintf(stderr, "game %d: %+d, %ld positions\n", g + 1, result, positions);
+    }
+
+    fclose(out);
+    delete black;
+    delete white;
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "skuaaaaa.h"
+#include "bitboard.h"
+#include "search.h"
+using namespace std;
+
+static_assert(SK_WIN == SEARCH_WIN, "SK_WIN must match SEARCH_WIN");
+static_assert(SK_PASS == PASS_MOVE, "SK_PASS must match PASS_MOVE");
+
+enum BatchKind { EVALUATE, SEARCH };
+
+/*
+ * A thread pool with one Search per thread. A batch is described by the
+ * fields below; all threads, the caller's included, claim positions from
+ * it through "next" until none are left.
+ */
+struct sk_engine {
+    vector<thread> threads;
+    vector<Search> searches;
+
+    mutex callLock;
+    mutex lock;
+    condition_variable wake;
+    condition_variable finished;
+    unsigned long generation;
+    int running;
+    bool quit;
+
+    BatchKind kind;
+    const sk_board *boards;
+    size_t count;
+    const sk_limits *limits;
+    double *scores;
+    sk_result *results;
+    atomic<size_t> next;
+};
+
+static void split(const sk_board *board, uint64_t *mine, uint64_t *theirs) {
+    *mine = (board->side_to_move == SK_BLACK) ? board->black : board->white;
+    *theirs = (board->side_to_move == SK_BLACK) ? board->white : board->black;
+}
+
+static void runSearch(Search *search, const sk_board *board, const sk_limits *limits,
+                      sk_result *result) {
+    uint64_t mine, theirs;
+    split(board, &mine, &theirs);
+    long long maxNodes = limits->max_nodes;
+    int maxMs = limits->max_ms;
+    long long solveNodes = 0;
+
+    if (64 - bbCount(mine | theirs) <= limits->exact_empties) {
+        // Under limits, the solver gets half of them; if it runs out, the
+        // rest goes to a heuristic search so there is still a result.
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        search->setLimits((maxNodes > 0) ? max(1LL, maxNodes / 2) : 0,
+            (maxMs > 0) ? max(1, maxMs / 2) : 0);
+
+        int score;
+        int move = search->solve(mine, theirs, &score);
+        if (!search->aborted) {
+            result->best_move = move;
+            result->exact = 1;
+            result->score = score;
+            result->depth = search->depthReached;
+            result->nodes = search->nodes;
+            return;
+        }
+
+        solveNodes = search->nodes;
+        int msUsed = chrono::duration_cast<chrono::milliseconds>(
+            chrono::steady_clock::now() - start).count();
+        if (maxNodes > 0) maxNodes = max(1LL, maxNodes - solveNodes);
+        if (maxMs > 0) maxMs = max(1, maxMs - msUsed);
+    }
+
+    double score;
+    int depth = (limits->depth < 1) ? 1 : limits->depth;
+    search->setLimits(maxNodes, maxMs);
+    result->best_move = search->search(mine, theirs, depth, &score);
+    result->exact = 0;
+    result->score = score;
+    result->depth = search->depthReached;
+    result->nodes = solveNodes + search->nodes;
+}
+
+/*
+ * Works on the engine's current batch until every position is claimed.
+ */
+static void runBatch(sk_engine *engine, Search *search) {
+    size_t i;
+    while ((i = engine->next.fetch_add(1)) < engine->count) {
+        if (engine->kind == EVALUATE) {
+            engine->scores[i] = sk_evaluate(&engine->boards[i]);
+        } else {
+            runSearch(search, &engine->boards[i], engine->limits, &engine->results[i]);
+        }
+    }
+}
+
+static void workerLoop(sk_engine *engine, int index) {
+    unsigned long seen = 0;
+    unique_lock<mutex> lk(engine->lock);
+    for (;;) {
+        while (!engine->quit && engine->generation == seen) engine->wake.wait(lk);
+        if (engine->quit) return;
+        seen = engine->generation;
+
+        lk.unlock();
+        runBatch(engine, &engine->searches[index]);
+        lk.lock();
+        if (--engine->running == 0) engine->finished.notify_one();
+    }
+}
+
+/*
+ * Hands a batch, already described in the engine, to every thread and
+ * returns once all of its positions are done.
+ */
+static void dispatch(sk_engine *engine) {
+    {
+        lock_guard<mutex> lk(engine->lock);
+        engine->next.store(0);
+        engine->running = engine->threads.size();
+        engine->generation++;
+    }
+    engine->wake.notify_all();
+
+    runBatch(engine, &engine->searches[0]);
+
+    unique_lock<mutex> lk(engine->lock);
+    while (engine->running > 0) engine->finished.wait(lk);
+}
+
+int sk_version(void) {
+    return SK_API_VERSION;
+}
+
+/*
+ * Sets up the standard starting position, black to move.
+ */
+void sk_board_start(sk_board *board) {
+    board->black = 0x0000000810000000ULL;
+    board->white = 0x0000001008000000ULL;
+    board->side_to_move = SK_BLACK;
+}
+
+/*
+ * Sets up a board from two bitboards. Fails if they overlap or the side
+ * is not SK_BLACK or SK_WHITE.
+ */
+int sk_board_init(sk_board *board, uint64_t black, uint64_t white, int side_to_move) {
+    if (board == NULL || (black & white) != 0) return SK_ERR_INVALID;
+    if (side_to_move != SK_BLACK && side_to_move != SK_WHITE) return SK_ERR_INVALID;
+    board->black = black;
+    board->white = white;
+    board->side_to_move = side_to_move;
+    return SK_OK;
+}
+
+/*
+ * Returns the squares the side to move may play on.
+ */
+uint64_t sk_legal_moves(const sk_board *board) {
+    uint64_t mine, theirs;
+    split(board, &mine, &theirs);
+    return bbMoves(mine, theirs);
+}
+
+/*
+ * Returns 1 if neither side can move, 0 otherwise.
+ */
+int sk_game_over(const sk_board *board) {
+    return bbMoves(board->black, board->white) == 0
+        && bbMoves(board->white, board->black) == 0;
+}
+
+/*
+ * Plays a square, or SK_PASS, for the side to move. Passing is only legal
+ * without any other move.
+ */
+int sk_play(sk_board *board, int square) {
+    uint64_t mine, theirs;
+    split(board, &mine, &theirs);
+    uint64_t legal = bbMoves(mine, theirs);
+
+    if (square == SK_PASS) {
+        if (legal != 0) return SK_ERR_ILLEGAL;
+    } else if (square < 0 || square > 63 || !(legal >> square & 1)) {
+        return SK_ERR_ILLEGAL;
+    }
+
+    bbDoMove(&mine, &theirs, square);
+    board->side_to_move = (board->side_to_move == SK_BLACK) ? SK_WHITE : SK_BLACK;
+    board->black = (board->side_to_move == SK_BLACK) ? mine : theirs;
+    board->white = (board->side_to_move == SK_BLACK) ? theirs : mine;
+    return SK_OK;
+}
+
+/*
+ * The engine's static evaluation of the board.
+ */
+double sk_evaluate(const sk_board *board) {
+    uint64_t mine, theirs;
+    split(board, &mine, &theirs);
+    return bbEvaluate(mine, theirs);
+}
+
+/*
+ * Searches one board on the calling thread. With at most
+ * limits->exact_empties empty squares the board is solved exactly;
+ * otherwise it is searched by iterative deepening to limits->depth. A
+ * solve under limits may use half of them; if it does not finish, the
+ * board is searched with the rest and the result is not exact.
+ */
+int sk_search(const sk_board *board, const sk_limits *limits, sk_result *result) {
+    if (board == NULL || limits == NULL || result == NULL) return SK_ERR_INVALID;
+    Search search;
+    runSearch(&search, board, limits, result);
+    return SK_OK;
+}
+
+/*
+ * Starts an engine with the given number of threads, counting the thread
+ * that makes the batch calls; 0 means one per core.
+ */
+sk_engine *sk_engine_create(int threads) {
+    if (threads <= 0) threads = thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    sk_engine *engine = new sk_engine();
+    engine->generation = 0;
+    engine->running = 0;
+    engine->quit = false;
+    engine->count = 0;
+    engine->searches.resize(threads);
+    for (int i = 1; i < threads; i++) {
+        engine->threads.push_back(thread(workerLoop, engine, i));
+    }
+    return engine;
+}
+
+/*
+ * Stops the engine's threads and frees it.
+ */
+void sk_engine_destroy(sk_engine *engine) {
+    if (engine == NULL) return;
+    {
+        lock_guard<mutex> lk(engine->lock);
+        engine->quit = true;
+    }
+    engine->wake.notify_all();
+    for (size_t i = 0; i < engine->threads.size(); i++) engine->threads[i].join();
+    delete engine;
+}
+
+/*
+ * Evaluates count boards in parallel into scores[0 .. count - 1].
+ */
+int sk_evaluate_batch(sk_engine *engine, const sk_board *boards, size_t count,
+                      double *scores) {
+    if (engine == NULL || (count > 0 && (boards == NULL || scores == NULL))) {
+        return SK_ERR_INVALID;
+    }
+    lock_guard<mutex> call(engine->callLock);
+    engine->kind = EVALUATE;
+    engine->boards = boards;
+    engine->count = count;
+    engine->scores = scores;
+    dispatch(engine);
+    return SK_OK;
+}
+
+/*
+ * Searches count boards in parallel, as sk_search() would, into
+ * results[0 .. count - 1]. The limits apply to each board separately.
+ */
+int sk_search_batch(sk_engine *engine, const sk_board *boards, size_t count,
+                    const sk_limits *limits, sk_result *results) {
+    if (engine == NULL || limits == NULL
+        || (count > 0 && (boards == NULL || results == NULL))) {
+        return SK_ERR_INVALID;
+    }
+    lock_guard<mutex> call(engine->callLock);
+    engine->kind = SEARCH;
+    engine->boards = boards;
+    engine->count = count;
+    engine->limits = limits;
+    engine->results = results;
+    dispatch(engine);
+    return SK_OK;
+}
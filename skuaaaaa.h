@@ -0,0 +1,85 @@
+#ifndef __SKUAAAAA_H__
+#define __SKUAAAAA_H__
+
+/*
+ * C API of libskuaaaaa.so, for running the engine in-process.
+ *
+ * Boards are plain structs of two bitboards, where square (x, y) is bit
+ * x + 8*y, plus the side to move. Scores are always for the side to move.
+ * Batch calls run on the engine's thread pool and write into buffers the
+ * caller provides; they allocate nothing per call. Batch calls on one
+ * engine are serialized; use one engine per calling thread to overlap them.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SK_API __attribute__((visibility("default")))
+
+#define SK_API_VERSION 1
+
+/* Sides, with the same values as the engine's Side enum. */
+#define SK_WHITE 0
+#define SK_BLACK 1
+
+/* Square number of a pass. */
+#define SK_PASS 64
+
+/* Return codes. */
+#define SK_OK 0
+#define SK_ERR_INVALID -1
+#define SK_ERR_ILLEGAL -2
+
+/* Finished games score SK_WIN plus or minus the final disc differential. */
+#define SK_WIN 1.e7
+
+typedef struct sk_board {
+    uint64_t black;
+    uint64_t white;
+    int side_to_move;
+} sk_board;
+
+typedef struct sk_limits {
+    int depth;              /* maximum search depth in plies */
+    long long max_nodes;    /* 0 for no limit */
+    int max_ms;             /* 0 for no limit */
+    int exact_empties;      /* solve exactly with at most this many empties */
+} sk_limits;
+
+typedef struct sk_result {
+    int best_move;          /* square, or SK_PASS */
+    int depth;              /* depth of the last completed iteration */
+    int exact;              /* 1 if score is the exact final disc differential */
+    double score;
+    long long nodes;
+} sk_result;
+
+typedef struct sk_engine sk_engine;
+
+SK_API int sk_version(void);
+
+SK_API void sk_board_start(sk_board *board);
+SK_API int sk_board_init(sk_board *board, uint64_t black, uint64_t white, int side_to_move);
+SK_API uint64_t sk_legal_moves(const sk_board *board);
+SK_API int sk_game_over(const sk_board *board);
+SK_API int sk_play(sk_board *board, int square);
+
+SK_API double sk_evaluate(const sk_board *board);
+SK_API int sk_search(const sk_board *board, const sk_limits *limits, sk_result *result);
+
+SK_API sk_engine *sk_engine_create(int threads);
+SK_API void sk_engine_destroy(sk_engine *engine);
+SK_API int sk_evaluate_batch(sk_engine *engine, const sk_board *boards, size_t count,
+                             double *scores);
+SK_API int sk_search_batch(sk_engine *engine, const sk_board *boards, size_t count,
+                           const sk_limits *limits, sk_result *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,15 +5,31 @@
 using namespace std;
 
 int main(int argc, char *argv[]) {    
-    // Read in side the player is on.
-    if (argc != 2)  {
-        cerr << "usage: " << argv[0] << " side" << endl;
+    // Read in side the player is on, and optionally the engine to use and
+    // a network weights file for the alpha-beta evaluation.
+    if (argc < 2 || argc > 4)  {
+        cerr << "usage: " << argv[0] << " side [alphabeta|mcts] [weights]" << endl;
         exit(-1);
     }
     Side side = (!strcmp(argv[1], "Black")) ? BLACK : WHITE;
+    Engine engine = ALPHA_BETA;
+    if (argc >= 3 && !strcmp(argv[2], "mcts")) {
+        engine = MONTE_CARLO;
+    } else if (argc >= 3 && strcmp(argv[2], "alphabeta")) {
+        cerr << "unknown engine " << argv[2] << "; use alphabeta or mcts" << endl;
+        exit(-1);
+    }
+    if (argc == 4 && engine == MONTE_CARLO) {
+        cerr << "network weights only apply to the alphabeta engine" << endl;
+        exit(-1);
+    }
 
     // Initialize player.
-    Player *player = new Player(side);
+    Player *player = new Player(side, engine);
+    if (argc == 4 && !player->loadNetwork(argv[3])) {
+        cerr << "could not load network weights from " << argv[3] << endl;
+        exit(-1);
+    }
 
     // Tell java wrapper that we are done initializing.
     cout << "Init done" << endl;